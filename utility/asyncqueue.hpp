@@ -48,7 +48,7 @@ private:
 
 // inlines
 
-inline void AsyncQueue::post_impl(const Operation &op) const
+inline void AsyncQueue::post(const Operation &op) const
 {
     return post_impl(op);
 }
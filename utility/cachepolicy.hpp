@@ -0,0 +1,402 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file cachepolicy.hpp
+ *
+ * Eviction/admission policies for LruCache2.
+ */
+
+#ifndef utility_cachepolicy_hpp_included_
+#define utility_cachepolicy_hpp_included_
+
+#include <cstdint>
+#include <list>
+#include <vector>
+#include <iterator>
+#include <functional>
+
+namespace utility {
+
+/** Policy interface (for items held in std::list<Item>, Item has at least
+ *  key, cost and segment members):
+ *
+ *      template <typename Item, typename CostType> class Policy {
+ *          // new cache limit
+ *          void limit(CostType limit);
+ *
+ *          // item with given key is accessed (hit or miss)
+ *          template <typename Key> void record(const Key &key);
+ *
+ *          // take ownership of a just loaded item (spliced from other list)
+ *          void admit(std::list<Item> &from, iterator it);
+ *
+ *          // cache hit on an admitted item
+ *          void hit(iterator it);
+ *
+ *          // give up admitted item (spliced to other list)
+ *          void release(std::list<Item> &to, iterator it);
+ *
+ *          // evict items until total <= limit; evict(item) is called just
+ *          // before item destruction and must update total
+ *          template <typename Evict>
+ *          std::size_t trim(const CostType &total, CostType limit
+ *                           , const Evict &evict);
+ *
+ *          // number of admitted items
+ *          std::size_t size() const;
+ *      };
+ */
+
+/** Classic LRU policy: all items are kept in a single list in the order of
+ *  their last use. Default for LruCache2.
+ */
+template <typename Item, typename CostType>
+class LruPolicy {
+public:
+    typedef std::list<Item> List;
+    typedef typename List::iterator iterator;
+
+    void limit(CostType) {}
+
+    template <typename Key> void record(const Key&) {}
+
+    void admit(List &from, iterator it) {
+        list_.splice(list_.end(), from, it);
+    }
+
+    void hit(iterator it) { list_.splice(list_.end(), list_, it); }
+
+    void release(List &to, iterator it) {
+        to.splice(to.end(), list_, it);
+    }
+
+    template <typename Evict>
+    std::size_t trim(const CostType &total, CostType limit
+                     , const Evict &evict)
+    {
+        std::size_t removed(0);
+        while ((total > limit) && !list_.empty()) {
+            evict(list_.front());
+            list_.pop_front();
+            ++removed;
+        }
+        return removed;
+    }
+
+    std::size_t size() const { return list_.size(); }
+
+private:
+    List list_;
+};
+
+/** Count-min sketch of access frequencies with 4-bit saturating counters (16
+ *  counters per 64-bit word, 4 counters per key). All counters are halved
+ *  after every sample period (10 times the table capacity) so that the
+ *  sketch ages old history.
+ */
+class FrequencySketch {
+public:
+    FrequencySketch() : size_() { ensureCapacity(0); }
+
+    /** Grows the table to accommodate given number of items. Growing resets
+     *  the sketch.
+     */
+    void ensureCapacity(std::size_t items) {
+        std::size_t width(16);
+        while (width < items) { width <<= 1; }
+        if (width <= table_.size()) { return; }
+
+        table_.assign(width, 0);
+        mask_ = width - 1;
+        sampleSize_ = 10 * width;
+        size_ = 0;
+    }
+
+    /** Records one access to key with given hash.
+     */
+    void increment(std::uint64_t hash) {
+        bool added(false);
+        for (int i(0); i < 4; ++i) {
+            std::uint64_t &word(table_[index(hash, i)]);
+            const auto shift(offset(hash, i));
+            if (((word >> shift) & 0xf) != 0xf) {
+                word += std::uint64_t(1) << shift;
+                added = true;
+            }
+        }
+
+        if (added && (++size_ >= sampleSize_)) { reset(); }
+    }
+
+    /** Returns estimated access frequency (0-15) of key with given hash.
+     */
+    unsigned int frequency(std::uint64_t hash) const {
+        unsigned int freq(0xf);
+        for (int i(0); i < 4; ++i) {
+            const unsigned int count((table_[index(hash, i)]
+                                      >> offset(hash, i)) & 0xf);
+            if (count < freq) { freq = count; }
+        }
+        return freq;
+    }
+
+private:
+    /** Word index for i-th counter.
+     */
+    std::size_t index(std::uint64_t hash, int i) const {
+        static const std::uint64_t seeds[] = {
+            0xc3a5c85c97cb3127ull, 0xb492b66fbe98f273ull
+            , 0x9ae16a3b2f90404full, 0xcbf29ce484222325ull
+        };
+        std::uint64_t h((hash + seeds[i]) * seeds[i]);
+        h += h >> 32;
+        return h & mask_;
+    }
+
+    /** Bit offset of i-th counter inside its word. Every counter uses
+     *  different quarter of the word.
+     */
+    static unsigned int offset(std::uint64_t hash, int i) {
+        return (((hash >> (i << 3)) & 3) + (i << 2)) << 2;
+    }
+
+    void reset() {
+        for (auto &word : table_) {
+            word = (word >> 1) & 0x7777777777777777ull;
+        }
+        size_ /= 2;
+    }
+
+    std::vector<std::uint64_t> table_;
+    std::size_t mask_;
+    std::size_t sampleSize_;
+    std::size_t size_;
+};
+
+/** W-TinyLFU policy: scan resistant LRU.
+ *
+ *  New items enter small LRU window (1 % of the cost limit). Items falling out
+ *  of the window become candidates for the main area, which is segmented
+ *  LRU (probation and protected, 80 % of the main area). When the cache is
+ *  over limit, the candidate competes with the probation's LRU victim and
+ *  the one with lower frequency estimate (FrequencySketch) is evicted. Items
+ *  hit in probation are promoted to protected; protected overflow is
+ *  demoted back to probation.
+ *
+ *  One-off accesses (e.g. bulk scan) therefore never push out frequently
+ *  used items. All operations are O(1) amortized; memory overhead is one
+ *  byte per item plus 8 bytes per item for the sketch.
+ */
+template <typename Item, typename CostType>
+class WTinyLfuPolicy {
+public:
+    typedef std::list<Item> List;
+    typedef typename List::iterator iterator;
+
+    WTinyLfuPolicy()
+        : limit_(), windowCost_(), protectedCost_(), candidates_()
+    {}
+
+    void limit(CostType limit) { limit_ = limit; }
+
+    template <typename Key> void record(const Key &key) {
+        sketch_.increment(std::hash<Key>()(key));
+    }
+
+    void admit(List &from, iterator it) {
+        it->segment = Segment::window;
+        window_.splice(window_.end(), from, it);
+        windowCost_ += it->cost;
+        sketch_.ensureCapacity(size());
+    }
+
+    void hit(iterator it);
+
+    void release(List &to, iterator it) {
+        switch (it->segment) {
+        case Segment::window:
+            windowCost_ -= it->cost;
+            to.splice(to.end(), window_, it);
+            break;
+
+        case Segment::probation:
+            to.splice(to.end(), probation_, it);
+            break;
+
+        case Segment::protected_:
+            protectedCost_ -= it->cost;
+            to.splice(to.end(), protected_, it);
+            break;
+        }
+    }
+
+    template <typename Evict>
+    std::size_t trim(const CostType &total, CostType limit
+                     , const Evict &evict);
+
+    std::size_t size() const {
+        return window_.size() + probation_.size() + protected_.size();
+    }
+
+private:
+    struct Segment {
+        enum : unsigned char { window, probation, protected_ };
+    };
+
+    CostType windowLimit() const { return limit_ / 100; }
+
+    CostType protectedLimit() const {
+        return ((limit_ - windowLimit()) / 10) * 8;
+    }
+
+    /** Candidate wins over victim if it is used more often.
+     */
+    bool admit(const Item &candidate, const Item &victim) const {
+        return (frequency(candidate) > frequency(victim));
+    }
+
+    unsigned int frequency(const Item &item) const {
+        return sketch_.frequency
+            (std::hash<typename std::decay<decltype(item.key)>::type>()
+             (item.key));
+    }
+
+    template <typename Evict>
+    void evictItem(List &list, iterator it, const Evict &evict) {
+        switch (it->segment) {
+        case Segment::window: windowCost_ -= it->cost; break;
+        case Segment::protected_: protectedCost_ -= it->cost; break;
+        }
+        evict(*it);
+        list.erase(it);
+    }
+
+    CostType limit_;
+
+    List window_;
+    List probation_;
+    List protected_;
+
+    CostType windowCost_;
+    CostType protectedCost_;
+
+    /** Number of candidates at the end of probation (valid only inside
+     *  trim).
+     */
+    std::size_t candidates_;
+
+    FrequencySketch sketch_;
+};
+
+// inlines
+
+template <typename Item, typename CostType>
+void WTinyLfuPolicy<Item, CostType>::hit(iterator it)
+{
+    switch (it->segment) {
+    case Segment::window:
+        window_.splice(window_.end(), window_, it);
+        return;
+
+    case Segment::protected_:
+        protected_.splice(protected_.end(), protected_, it);
+        return;
+    }
+
+    // probation -> protected
+    it->segment = Segment::protected_;
+    protected_.splice(protected_.end(), probation_, it);
+    protectedCost_ += it->cost;
+
+    // demote protected overflow to probation
+    const auto plimit(protectedLimit());
+    while ((protectedCost_ > plimit) && (protected_.size() > 1)) {
+        auto demoted(protected_.begin());
+        demoted->segment = Segment::probation;
+        protectedCost_ -= demoted->cost;
+        probation_.splice(probation_.end(), protected_, demoted);
+    }
+}
+
+template <typename Item, typename CostType>
+template <typename Evict>
+std::size_t WTinyLfuPolicy<Item, CostType>::trim(const CostType &total
+                                                 , CostType limit
+                                                 , const Evict &evict)
+{
+    // window overflow -> candidates
+    const auto wlimit(windowLimit());
+    while ((windowCost_ > wlimit) && !window_.empty()) {
+        auto candidate(window_.begin());
+        candidate->segment = Segment::probation;
+        windowCost_ -= candidate->cost;
+        probation_.splice(probation_.end(), window_, candidate);
+        ++candidates_;
+    }
+
+    std::size_t removed(0);
+    while (total > limit) {
+        if (probation_.empty()) {
+            // nothing to decide, evict from other segments
+            if (!protected_.empty()) {
+                evictItem(protected_, protected_.begin(), evict);
+            } else if (!window_.empty()) {
+                evictItem(window_, window_.begin(), evict);
+            } else {
+                break;
+            }
+            ++removed;
+            continue;
+        }
+
+        auto victim(probation_.begin());
+        if (!candidates_) {
+            evictItem(probation_, victim, evict);
+            ++removed;
+            continue;
+        }
+
+        auto candidate(std::prev(probation_.end()));
+        if ((candidate == victim) || !admit(*candidate, *victim)) {
+            // candidate rejected
+            evictItem(probation_, candidate, evict);
+            --candidates_;
+        } else {
+            // victim is candidate as well if there is nothing else
+            if (probation_.size() <= candidates_) { --candidates_; }
+            evictItem(probation_, victim, evict);
+        }
+        ++removed;
+    }
+
+    // surviving candidates are part of the main area now
+    candidates_ = 0;
+    return removed;
+}
+
+} // namespace utility
+
+#endif // utility_cachepolicy_hpp_included_
@@ -0,0 +1,203 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <ostream>
+
+#include "cachestats.hpp"
+
+namespace utility {
+
+constexpr std::size_t CacheStats::HistogramSize;
+
+double CacheStats::hitRatio() const
+{
+    const auto total(hits + misses);
+    return total ? double(hits) / total : .0;
+}
+
+std::uint64_t CacheStats::loadLatencyQuantile(double q) const
+{
+    std::uint64_t total(0);
+    for (auto count : loadLatency) { total += count; }
+    if (!total) { return 0; }
+
+    const auto limit(q * total);
+    std::uint64_t sum(0);
+    for (std::size_t i(0); i < HistogramSize; ++i) {
+        sum += loadLatency[i];
+        if (sum >= limit) { return std::uint64_t(2) << i; }
+    }
+
+    return std::uint64_t(2) << (HistogramSize - 1);
+}
+
+CacheStats& CacheStats::operator-=(const CacheStats &other)
+{
+    hits -= other.hits;
+    misses -= other.misses;
+    stale -= other.stale;
+    waits -= other.waits;
+    loads -= other.loads;
+    failures -= other.failures;
+    evictions -= other.evictions;
+    evictedCost -= other.evictedCost;
+    expirations -= other.expirations;
+    for (std::size_t i(0); i < HistogramSize; ++i) {
+        loadLatency[i] -= other.loadLatency[i];
+    }
+    return *this;
+}
+
+CacheStats& CacheStats::operator+=(const CacheStats &other)
+{
+    hits += other.hits;
+    misses += other.misses;
+    stale += other.stale;
+    waits += other.waits;
+    loads += other.loads;
+    failures += other.failures;
+    evictions += other.evictions;
+    evictedCost += other.evictedCost;
+    expirations += other.expirations;
+    for (std::size_t i(0); i < HistogramSize; ++i) {
+        loadLatency[i] += other.loadLatency[i];
+    }
+    items += other.items;
+    cost += other.cost;
+    return *this;
+}
+
+void CacheStats::dump(std::ostream &os, const std::string &name) const
+{
+    os << name << "hits=" << hits << '\n'
+       << name << "misses=" << misses << '\n'
+       << name << "stale=" << stale << '\n'
+       << name << "waits=" << waits << '\n'
+       << name << "loads=" << loads << '\n'
+       << name << "failures=" << failures << '\n'
+       << name << "evictions=" << evictions << '\n'
+       << name << "evictedCost=" << evictedCost << '\n'
+       << name << "expirations=" << expirations << '\n'
+       << name << "items=" << items << '\n'
+       << name << "cost=" << cost << '\n'
+       << name << "hitRatio=" << hitRatio() << '\n'
+       << name << "loadLatency.p50=" << loadLatencyQuantile(.5) << '\n'
+       << name << "loadLatency.p99=" << loadLatencyQuantile(.99) << '\n'
+        ;
+}
+
+namespace {
+
+/** Slots needed to cover the longest window (current slot is ignored).
+ */
+int slots(const CacheStatsWindow::Windows &windows)
+{
+    std::size_t longest(0);
+    for (auto window : windows) { longest = std::max(longest, window); }
+    return int(longest + 1);
+}
+
+} // namespace
+
+CacheStatsWindow::CacheStatsWindow(const Windows &windows)
+    : windows_(windows)
+    , hits_(slots(windows)), misses_(slots(windows)), waits_(slots(windows))
+    , loads_(slots(windows)), failures_(slots(windows))
+    , evictions_(slots(windows)), evictedCost_(slots(windows))
+{}
+
+void CacheStatsWindow::update(const CacheStats &stats)
+{
+    const auto diff(stats - last_);
+    last_ = stats;
+
+    hits_.event(diff.hits);
+    misses_.event(diff.misses);
+    waits_.event(diff.waits);
+    loads_.event(diff.loads);
+    failures_.event(diff.failures);
+    evictions_.event(diff.evictions);
+    evictedCost_.event(diff.evictedCost);
+}
+
+void CacheStatsWindow::report(std::ostream &os, const std::string &name)
+    const
+{
+    hits_.total(os, name + "hits.", windows_);
+    misses_.total(os, name + "misses.", windows_);
+    waits_.total(os, name + "waits.", windows_);
+    loads_.total(os, name + "loads.", windows_);
+    failures_.total(os, name + "failures.", windows_);
+    evictions_.total(os, name + "evictions.", windows_);
+    evictedCost_.total(os, name + "evictedCost.", windows_);
+
+    for (auto count : windows_) {
+        const auto hits(hits_.total(count));
+        const auto total(hits + misses_.total(count));
+        os << name << "hitRatio." << count << '='
+           << (total ? double(hits) / total : .0) << '\n';
+    }
+}
+
+namespace detail {
+
+void CacheCounters::load(const Clock::time_point &start)
+{
+    inc(loads_);
+
+    const auto us(std::chrono::duration_cast<std::chrono::microseconds>
+                  (Clock::now() - start).count());
+
+    // bucket = floor(log2(us))
+    std::size_t bucket(0);
+    for (auto v(us >> 1); v && (bucket + 1 < CacheStats::HistogramSize);
+         v >>= 1)
+    {
+        ++bucket;
+    }
+    inc(loadLatency_[bucket]);
+}
+
+void CacheCounters::snapshot(CacheStats &stats) const
+{
+    stats.hits = get(hits_);
+    stats.misses = get(misses_);
+    stats.stale = get(stale_);
+    stats.waits = get(waits_);
+    stats.loads = get(loads_);
+    stats.failures = get(failures_);
+    stats.evictions = get(evictions_);
+    stats.evictedCost = get(evictedCost_);
+    stats.expirations = get(expirations_);
+    for (std::size_t i(0); i < CacheStats::HistogramSize; ++i) {
+        stats.loadLatency[i] = get(loadLatency_[i]);
+    }
+}
+
+} // namespace detail
+
+} // namespace utility
@@ -0,0 +1,205 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file cachestats.hpp
+ *
+ * Cache effectiveness statistics.
+ */
+
+#ifndef utility_cachestats_hpp_included_
+#define utility_cachestats_hpp_included_
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <string>
+
+#include "eventcounter.hpp"
+
+namespace utility {
+
+/** Snapshot of cache statistics. All counters are cumulative since cache
+ *  creation.
+ */
+struct CacheStats {
+    /** Load latency histogram: bucket i counts loads that took [2^i, 2^(i+1))
+     *  microseconds (bucket 0 also includes faster ones, last bucket also
+     *  includes slower ones).
+     */
+    static constexpr std::size_t HistogramSize = 32;
+    typedef std::array<std::uint64_t, HistogramSize> Histogram;
+
+    std::uint64_t hits;
+    std::uint64_t misses;
+
+    /** Hits served with expired value (subset of hits).
+     */
+    std::uint64_t stale;
+
+    /** Requests that found the item being loaded by someone else.
+     */
+    std::uint64_t waits;
+
+    std::uint64_t loads;
+    std::uint64_t failures;
+    std::uint64_t evictions;
+    std::uint64_t evictedCost;
+    std::uint64_t expirations;
+
+    Histogram loadLatency;
+
+    /** Current number of items and their total cost.
+     */
+    std::size_t items;
+    std::uint64_t cost;
+
+    CacheStats()
+        : hits(), misses(), stale(), waits(), loads(), failures()
+        , evictions(), evictedCost(), expirations(), loadLatency(), items()
+        , cost()
+    {}
+
+    double hitRatio() const;
+
+    /** Returns upper bound of given load latency quantile (0-1) in
+     *  microseconds (resolution is power of two).
+     */
+    std::uint64_t loadLatencyQuantile(double q) const;
+
+    /** Difference of counters (current values are kept).
+     */
+    CacheStats& operator-=(const CacheStats &other);
+
+    /** Sum of counters and current values (e.g. over cache shards).
+     */
+    CacheStats& operator+=(const CacheStats &other);
+
+    /** Reports statistics to output stream (one name.value=value per line).
+     */
+    void dump(std::ostream &os, const std::string &name) const;
+};
+
+inline CacheStats operator-(CacheStats l, const CacheStats &r) {
+    return l -= r;
+}
+
+/** Cache statistics over sliding time windows. Feed with stats() snapshots
+ *  periodically (e.g. every second).
+ */
+class CacheStatsWindow {
+public:
+    /** Windows (in seconds) reported by report().
+     */
+    typedef EventCounter::Counts Windows;
+
+    CacheStatsWindow(const Windows &windows = { 5, 60, 300 });
+
+    /** Records difference between given and previous snapshot.
+     */
+    void update(const CacheStats &stats);
+
+    /** Reports totals and hit ratios over configured windows.
+     */
+    void report(std::ostream &os, const std::string &name) const;
+
+private:
+    Windows windows_;
+    CacheStats last_;
+    EventCounter hits_;
+    EventCounter misses_;
+    EventCounter waits_;
+    EventCounter loads_;
+    EventCounter failures_;
+    EventCounter evictions_;
+    EventCounter evictedCost_;
+};
+
+namespace detail {
+
+/** Live cache counters. Updated with relaxed atomics.
+ */
+class CacheCounters {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    CacheCounters()
+        : hits_(), misses_(), stale_(), waits_(), loads_(), failures_()
+        , evictions_(), evictedCost_(), expirations_(), loadLatency_()
+    {}
+
+    void hit() { inc(hits_); }
+    void miss() { inc(misses_); }
+    void stale() { inc(stale_); }
+    void expiration() { inc(expirations_); }
+    void wait() { inc(waits_); }
+    void failure() { inc(failures_); }
+
+    void eviction(std::uint64_t cost) {
+        inc(evictions_);
+        inc(evictedCost_, cost);
+    }
+
+    /** Records successful load started at given time.
+     */
+    void load(const Clock::time_point &start);
+
+    std::uint64_t hits() const { return get(hits_); }
+    std::uint64_t misses() const { return get(misses_); }
+
+    /** Fills in counters, items and cost are left intact.
+     */
+    void snapshot(CacheStats &stats) const;
+
+private:
+    typedef std::atomic<std::uint64_t> Counter;
+
+    static void inc(Counter &counter, std::uint64_t value = 1) {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    static std::uint64_t get(const Counter &counter) {
+        return counter.load(std::memory_order_relaxed);
+    }
+
+    Counter hits_;
+    Counter misses_;
+    Counter stale_;
+    Counter waits_;
+    Counter loads_;
+    Counter failures_;
+    Counter evictions_;
+    Counter evictedCost_;
+    Counter expirations_;
+    Counter loadLatency_[CacheStats::HistogramSize];
+};
+
+} // namespace detail
+
+} // namespace utility
+
+#endif // utility_cachestats_hpp_included_
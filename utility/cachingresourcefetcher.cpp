@@ -0,0 +1,232 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "dbglog/dbglog.hpp"
+
+#include "cachingresourcefetcher.hpp"
+#include "lrucache2.hpp"
+
+namespace utility {
+
+typedef ResourceFetcher::Query Query;
+typedef ResourceFetcher::MultiQuery MultiQuery;
+
+namespace {
+
+/** Cache key: location and options.
+ */
+std::string cacheKey(const Query &query)
+{
+    auto key(query.location());
+    for (const auto &option : query.options()) {
+        key.push_back('\n');
+        key.append(option.first);
+        key.push_back(':');
+        key.append(option.second);
+    }
+    return key;
+}
+
+/** One perform() call.
+ */
+struct Request {
+    MultiQuery query;
+    ResourceFetcher::Done done;
+
+    /** Number of unresolved queries + 1 (for the perform() call itself).
+     */
+    std::atomic<std::size_t> remaining;
+
+    Request(MultiQuery &&query, const ResourceFetcher::Done &done)
+        : query(std::move(query)), done(done)
+        , remaining(this->query.size() + 1)
+    {}
+
+    void resolved() {
+        if (!--remaining) { done(std::move(query)); }
+    }
+};
+
+} // namespace
+
+struct CachingResourceFetcher::Detail {
+    typedef LruCache2<std::string, Query> Cache;
+
+    /** Query waiting to be sent to the backend.
+     */
+    struct Pending {
+        Query query;
+        Cache::LoadDone done;
+
+        Pending(const Query &query, const Cache::LoadDone &done)
+            : query(query), done(done)
+        {}
+    };
+
+    typedef std::vector<Pending> PendingList;
+
+    Detail(const ResourceFetcher::pointer &backend, std::size_t byteBudget
+           , std::time_t defaultTtl)
+        : backend(backend), cache(byteBudget), defaultTtl(defaultTtl)
+    {}
+
+    /** Sends pending queries to the backend.
+     */
+    static void fetch(const std::shared_ptr<Detail> &detail
+                      , PendingList &&pending);
+
+    /** Stores fetched query in the cache (if cacheable) and resolves all its
+     *  waiters.
+     */
+    void finish(Query &query, const Cache::LoadDone &done);
+
+    /** Fills in query from cache value.
+     */
+    static void fill(Query &query, const Cache::expected_value &value);
+
+    ResourceFetcher::pointer backend;
+    Cache cache;
+    std::time_t defaultTtl;
+};
+
+void CachingResourceFetcher::Detail::fetch(const std::shared_ptr<Detail> &detail
+                                           , PendingList &&pending)
+{
+    MultiQuery query(pending.size());
+    auto loads(std::make_shared<std::vector<Cache::LoadDone>>());
+    loads->reserve(pending.size());
+    for (auto &p : pending) {
+        query.add(std::move(p.query));
+        loads->push_back(p.done);
+    }
+
+    try {
+        detail->backend->perform
+            (std::move(query), [detail, loads](MultiQuery &&query)
+        {
+            // backend must return what it got; extra queries are ignored,
+            // loads without a query fail
+            const auto size(std::min(query.size(), loads->size()));
+            if (query.size() != loads->size()) {
+                LOG(err2) << "Backend returned " << query.size()
+                          << " queries instead of " << loads->size() << ".";
+            }
+
+            for (std::size_t i(0); i < size; ++i) {
+                detail->finish(query[i], (*loads)[i]);
+            }
+
+            for (std::size_t i(size), e(loads->size()); i < e; ++i) {
+                (*loads)[i](std::make_exception_ptr
+                            (std::logic_error("Query lost by backend.")));
+            }
+        });
+    } catch (...) {
+        for (const auto &load : *loads) { load(std::current_exception()); }
+    }
+}
+
+void CachingResourceFetcher::Detail::finish(Query &query
+                                            , const Cache::LoadDone &done)
+{
+    const auto uncached([&]()
+    {
+        done.uncached(std::make_shared<Query>(std::move(query)));
+    });
+
+    if (!query.valid()) { return uncached(); }
+
+    const auto &body(query.get());
+    const auto now(std::time(nullptr));
+    auto expires(body.expires);
+    if (expires < 0) {
+        if (!defaultTtl) { return uncached(); }
+        expires = now + defaultTtl;
+    }
+    if (expires <= now) { return uncached(); }
+
+    const std::size_t cost(sizeof(Query) + query.location().size()
+                           + body.data.size() + body.contentType.size());
+    done(std::make_shared<Query>(std::move(query)), cost, expires);
+}
+
+void CachingResourceFetcher::Detail::fill(Query &query
+                                          , const Cache::expected_value &value)
+{
+    try {
+        query.copyResult(*value.get());
+    } catch (...) {
+        query.error(std::current_exception());
+    }
+}
+
+CachingResourceFetcher
+::CachingResourceFetcher(const ResourceFetcher::pointer &backend
+                         , std::size_t byteBudget, std::time_t defaultTtl)
+    : detail_(std::make_shared<Detail>(backend, byteBudget, defaultTtl))
+{}
+
+CachingResourceFetcher::~CachingResourceFetcher() {}
+
+CacheStats CachingResourceFetcher::stats() const
+{
+    return detail_->cache.stats();
+}
+
+void CachingResourceFetcher::perform_impl(MultiQuery query
+                                          , const Done &done) const
+{
+    auto request(std::make_shared<Request>(std::move(query), done));
+
+    // loads of missing queries are collected and sent in one batch
+    Detail::PendingList pending;
+    const auto size(request->query.size());
+    for (std::size_t i(0); i < size; ++i) {
+        const auto &q(request->query[i]);
+        detail_->cache.getAsync
+            (cacheKey(q), [&](const std::string&
+                              , const Detail::Cache::LoadDone &load)
+            {
+                pending.emplace_back(q, load);
+            }
+            , [request, i](const Detail::Cache::expected_value &value)
+            {
+                Detail::fill(request->query[i], value);
+                request->resolved();
+            });
+    }
+
+    if (!pending.empty()) { Detail::fetch(detail_, std::move(pending)); }
+
+    request->resolved();
+}
+
+} // namespace utility
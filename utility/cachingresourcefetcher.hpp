@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file utility/cachingresourcefetcher.hpp
+ *
+ * Coalescing and caching ResourceFetcher decorator.
+ */
+
+#ifndef utility_cachingresourcefetcher_hpp_included_
+#define utility_cachingresourcefetcher_hpp_included_
+
+#include <memory>
+
+#include "resourcefetcher.hpp"
+#include "cachestats.hpp"
+
+namespace utility {
+
+/** ResourceFetcher decorator that
+ *
+ *  * collapses identical (same location and options) in-flight queries into
+ *    one backend fetch and fans the result out to all callers
+ *  * keeps successfully fetched bodies in memory (LRU, limited by byte
+ *    budget) until their Body::expires time
+ *
+ *  Bodies without expiry time are cached for defaultTtl seconds (zero means
+ *  not at all). Failed queries are never cached.
+ *
+ *  Queries missing in the cache are sent to the backend in one MultiQuery
+ *  per perform() call. Backend must return queries in the same order.
+ *  Queries missing in the backend's answer fail, extra ones are ignored.
+ */
+class CachingResourceFetcher : public ResourceFetcher {
+public:
+    CachingResourceFetcher(const ResourceFetcher::pointer &backend
+                           , std::size_t byteBudget
+                           , std::time_t defaultTtl = 0);
+
+    virtual ~CachingResourceFetcher();
+
+    CacheStats stats() const;
+
+    struct Detail;
+
+private:
+    virtual void perform_impl(MultiQuery query, const Done &done) const;
+
+    std::shared_ptr<Detail> detail_;
+};
+
+} // namespace utility
+
+#endif // utility_cachingresourcefetcher_hpp_included_
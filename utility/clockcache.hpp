@@ -0,0 +1,215 @@
+/**
+ * Copyright (c) 2017 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef utility_clockcache_hpp_included_
+#define utility_clockcache_hpp_included_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+
+#include "dbglog/dbglog.hpp"
+
+#include "lrucache.hpp"
+
+namespace utility {
+
+/** CLOCK (second-chance) cache for arbitrary values.
+ *  Drop-in alternative to LruCache, uses the same LruCacheTraits.
+ *
+ *  Values are held in a ring and indexed by a hash map (key type must be
+ *  hashable by Hash). Hit only sets entry's reference bit (atomically, under
+ *  shared lock) so concurrent readers never block each other nor reorder any
+ *  index. The lock is std::shared_timed_mutex (i.e. C++14 is required):
+ *  unlike boost::shared_mutex, which guards its state by an internal mutex,
+ *  it maps to pthread rwlock whose shared acquisition is a single atomic
+ *  update. Eviction sweeps the ring: referenced entries get second chance
+ *  (their bit is cleared), first unreferenced entry is removed.
+ *
+ *  All operations on cache are thread safe.
+ */
+template <typename Value, typename TraitsType = LruCacheTraits<Value>
+          , typename Hash = std::hash<typename std::remove_reference
+                                      <decltype(TraitsType::key
+                                                (detail::reference<Value>()))>
+                                      ::type> >
+class ClockCache : boost::noncopyable {
+public:
+    typedef TraitsType Traits;
+    typedef std::shared_ptr<Value> value_pointer;
+
+    /** Determine key type via traits
+     */
+    typedef typename std::remove_reference
+    <decltype(Traits::key(detail::reference<Value>()))>
+    ::type key_type;
+
+    /** Determine cost type via traits
+     */
+    typedef typename std::remove_reference
+    <decltype(Traits::cost(detail::reference<Value>()))>
+    ::type cost_type;
+
+    /** Create cache.
+     */
+    ClockCache() : hand_(), totalCost_() {}
+
+    /** Insert new element to cache. Returns false on conflict.
+     */
+    bool insert(const value_pointer &v);
+
+    /** Returns element under key or nullptr if not found.
+     *  Element is marked as referenced.
+     */
+    value_pointer get(const key_type &key);
+
+    /** Evicts as many as needed elements until total cost of all items in the
+     *  cache is not greated than provided limit.
+     */
+    std::size_t trim(cost_type limit);
+
+    /** Return total cost of items in cache
+     */
+    cost_type totalCost();
+
+private:
+    /** Cache entry.
+     */
+    struct Entry {
+        value_pointer value;
+        key_type key;
+        std::atomic<bool> referenced;
+
+        Entry(const value_pointer &value, const key_type &key)
+            : value(value), key(key), referenced(false)
+        {}
+    };
+
+    typedef std::unique_ptr<Entry> EntryPointer;
+    typedef std::vector<EntryPointer> Ring;
+    typedef std::unordered_map<key_type, Entry*, Hash> Index;
+
+    Ring ring_; // all is stored here
+    Index index_; // key -> entry mapping
+    std::size_t hand_; // clock hand, index into ring_
+
+    cost_type totalCost_; // total cost of all values in the cache
+
+    std::shared_timed_mutex mutex_;
+};
+
+template <typename Value, typename TraitsType, typename Hash>
+bool ClockCache<Value, TraitsType, Hash>::insert(const value_pointer &v)
+{
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+
+    EntryPointer entry(new Entry(v, Traits::key(*v)));
+    if (!index_.insert(typename Index::value_type
+                       (entry->key, entry.get())).second)
+    {
+        // key conflict!
+        return false;
+    }
+
+    ring_.push_back(std::move(entry));
+    totalCost_ += Traits::cost(*v);
+    return true;
+}
+
+template <typename Value, typename TraitsType, typename Hash>
+typename ClockCache<Value, TraitsType, Hash>::value_pointer
+ClockCache<Value, TraitsType, Hash>::get(const key_type &key)
+{
+    std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+
+    auto findex(index_.find(key));
+    if (findex == index_.end()) {
+        // not found -> nullptr
+        return {};
+    }
+
+    auto &entry(*findex->second);
+
+    // do not dirty the cache line when already set
+    if (!entry.referenced.load(std::memory_order_relaxed)) {
+        entry.referenced.store(true, std::memory_order_relaxed);
+    }
+
+    return entry.value;
+}
+
+template <typename Value, typename TraitsType, typename Hash>
+std::size_t ClockCache<Value, TraitsType, Hash>::trim(cost_type limit)
+{
+    std::unique_lock<std::shared_timed_mutex> lock(mutex_);
+
+    std::size_t removed(0);
+
+    // every entry is cleared during first sweep -> terminates in at most two
+    // full turns of the hand
+    while ((totalCost_ > limit) && !ring_.empty()) {
+        if (hand_ >= ring_.size()) { hand_ = 0; }
+
+        auto &entry(*ring_[hand_]);
+        if (entry.referenced.load(std::memory_order_relaxed)) {
+            // second chance
+            entry.referenced.store(false, std::memory_order_relaxed);
+            ++hand_;
+            continue;
+        }
+
+        LOG(debug) << "clock-cache: removing value=" << entry.value.get()
+                   << ", key=" << entry.key << " because total "
+                   << totalCost_ << " > " << limit;
+
+        // remove entry and update total cost; last entry takes its place in
+        // the ring and is inspected next
+        totalCost_ -= Traits::cost(*entry.value);
+        index_.erase(entry.key);
+        ring_[hand_] = std::move(ring_.back());
+        ring_.pop_back();
+        ++removed;
+    }
+
+    return removed;
+}
+
+template <typename Value, typename TraitsType, typename Hash>
+typename ClockCache<Value, TraitsType, Hash>::cost_type
+ClockCache<Value, TraitsType, Hash>::totalCost()
+{
+    std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+    return totalCost_;
+}
+
+} // namespace utility
+
+#endif // utility_clockcache_hpp_included_
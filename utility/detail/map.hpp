@@ -29,14 +29,34 @@
 #include <cstdlib>
 #include <utility>
 #include <type_traits>
+#include <vector>
+#include <iterator>
+#include <exception>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <boost/range.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/format.hpp>
+#include <boost/optional.hpp>
 #include <boost/utility/result_of.hpp>
 
 #include "dbglog/dbglog.hpp"
 
+#include "../logging.hpp"
+
 namespace utility { namespace detail {
 
+/** Default number of threads for map.
+ */
+inline std::size_t mapThreads() {
+    // NB: std::thread::hardware_concurrency() returned 0 at the time when this
+    // was written, using boost::thread::hardware_concurrency() instead
+    if (std::getenv("NO_THREADS")) { return 1; }
+    return boost::thread::hardware_concurrency();
+}
+
 template <typename CallResult>
 class Result {
 public:
@@ -103,10 +123,12 @@ public:
                     , const Callable &callable, Args2&& ...args)
         const
     {
-        for (const auto &value : values) {
-            dbglog::thread_id(str(boost::format("%s [%d/%d]")
-                                  % name % (index + 1) % count));
+        // set once per range
+        dbglog::thread_id(str(boost::format("%s [%d-%d/%d]")
+                              % name % (index + 1)
+                              % (index + boost::size(values)) % count));
 
+        for (const auto &value : values) {
             try {
                 result->set(callable(value, std::forward<Args2>(args)...));
             } catch(...) {
@@ -114,11 +136,269 @@ public:
             }
 
             ++result;
-            ++index;
         }
     }
 };
 
+} // namespace detail
+
+struct MapOptions;
+
+namespace detail {
+
+/** Result list of map. Undefined when MapOptions is passed in place of
+ *  sequence, i.e. it disables plain map overload in such case.
+ */
+template <typename Sequence, typename Callable, typename... Args>
+struct map_result {
+    typedef typename map_helper<Sequence, Callable, Args...>::ResultList type;
+};
+
+template <typename Callable, typename... Args>
+struct map_result<MapOptions, Callable, Args...> {};
+
+/** Shared state of dynamically scheduled map.
+ */
+template <typename Sequence, typename ResultList, typename Call>
+class DynamicMap {
+public:
+    DynamicMap(const std::string &name, const Sequence &values
+               , ResultList &result, const Call &call
+               , std::size_t count, std::size_t chunk)
+        : name_(name), values_(values), result_(result), call_(call)
+        , count_(count), chunk_(chunk), next_(0), done_(0)
+    {}
+
+    /** Processes chunks until there is none left.
+     */
+    void work() {
+        for (;;) {
+            const auto start(next_.fetch_add(chunk_));
+            if (start >= count_) { return; }
+            const auto end(std::min(start + chunk_, count_));
+
+            {
+                LogThreadId logThreadId
+                    ("%s [%d-%d/%d]", name_, start + 1, end, count_);
+
+                auto ivalue(boost::begin(values_) + start);
+                auto iresult(result_.begin() + start);
+                for (auto i(start); i < end; ++i, ++ivalue, ++iresult) {
+                    try {
+                        iresult->set(call_(*ivalue));
+                    } catch(...) {
+                        iresult->set(std::current_exception());
+                    }
+                }
+            }
+
+            if ((done_.fetch_add(end - start) + end - start) == count_) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.notify_all();
+            }
+        }
+    }
+
+    /** Waits until all items are processed.
+     */
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() { return done_ == count_; });
+    }
+
+private:
+    const std::string name_;
+    const Sequence &values_;
+    ResultList &result_;
+    const Call &call_;
+    const std::size_t count_;
+    const std::size_t chunk_;
+
+    std::atomic<std::size_t> next_;
+
+    std::atomic<std::size_t> done_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
+
+/** Value type produced by generator.
+ */
+template <typename Generator>
+struct GeneratorValue {
+    typedef typename std::decay
+    <decltype(*std::declval<Generator&>()())>::type type;
+};
+
+template <typename Iterator>
+class RangeGenerator {
+public:
+    typedef typename std::iterator_traits<Iterator>::value_type value_type;
+
+    RangeGenerator(Iterator begin, Iterator end) : begin_(begin), end_(end) {}
+
+    boost::optional<value_type> operator()() {
+        if (begin_ == end_) { return boost::none; }
+        return *begin_++;
+    }
+
+private:
+    Iterator begin_;
+    Iterator end_;
+};
+
+/** Shared state of streaming map.
+ */
+template <typename Generator, typename Call, typename Sink>
+class StreamMap {
+public:
+    typedef typename GeneratorValue<Generator>::type Value;
+    typedef typename std::decay
+    <decltype(std::declval<const Call&>()(std::declval<const Value&>()))>
+    ::type CallResult;
+    typedef detail::Result<CallResult> Result;
+
+    StreamMap(const std::string &name, Generator &generator
+              , const Call &call, const Sink &sink, std::size_t window)
+        : name_(name), generator_(generator), call_(call), sink_(sink)
+        , window_(window), ring_(window), next_(0), delivered_(0)
+        , active_(0), exhausted_(false), delivering_(false)
+    {}
+
+    /** Pulls and processes items until input is exhausted.
+     */
+    void work();
+
+    /** Waits until all items are processed and delivered. Rethrows
+     *  generator/sink error.
+     */
+    void wait();
+
+private:
+    /** Passes all ready items to the sink (unless someone else is doing it).
+     */
+    void deliver(std::unique_lock<std::mutex> &lock);
+
+    void fail(const std::exception_ptr &exc) {
+        if (!error_) { error_ = exc; }
+        cond_.notify_all();
+    }
+
+    bool stopped() const { return exhausted_ || error_; }
+
+    bool finished() const {
+        return (stopped() && !active_ && !delivering_
+                && (error_ || (delivered_ == next_)));
+    }
+
+    const std::string name_;
+    Generator &generator_;
+    const Call &call_;
+    const Sink &sink_;
+    const std::size_t window_;
+
+    /** Reorder window: item with given index is at index % window.
+     */
+    std::vector<boost::optional<Result>> ring_;
+
+    std::size_t next_; // index of next item pulled from the generator
+    std::size_t delivered_; // number of items passed to the sink
+    std::size_t active_; // number of items being processed
+    bool exhausted_;
+    bool delivering_;
+    std::exception_ptr error_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
+
+template <typename Generator, typename Call, typename Sink>
+void StreamMap<Generator, Call, Sink>::work()
+{
+    LogThreadId logThreadId(name_);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        // wait for room in the window
+        cond_.wait(lock, [this]()
+        {
+            return stopped() || ((next_ - delivered_) < window_);
+        });
+        if (stopped()) { return; }
+
+        boost::optional<Value> value;
+        try {
+            value = generator_();
+        } catch (...) {
+            fail(std::current_exception());
+            return;
+        }
+
+        if (!value) {
+            exhausted_ = true;
+            cond_.notify_all();
+            return;
+        }
+
+        const auto index(next_++);
+        ++active_;
+        lock.unlock();
+
+        Result result;
+        try {
+            result.set(call_(*value));
+        } catch(...) {
+            result.set(std::current_exception());
+        }
+
+        lock.lock();
+        ring_[index % window_] = std::move(result);
+        --active_;
+        deliver(lock);
+    }
+}
+
+template <typename Generator, typename Call, typename Sink>
+void StreamMap<Generator, Call, Sink>::deliver
+(std::unique_lock<std::mutex> &lock)
+{
+    if (delivering_) { return; }
+    delivering_ = true;
+
+    while (!error_) {
+        auto &slot(ring_[delivered_ % window_]);
+        if (!slot) { break; }
+
+        Result result(std::move(*slot));
+        slot = boost::none;
+
+        lock.unlock();
+        try {
+            sink_(result);
+        } catch (...) {
+            lock.lock();
+            fail(std::current_exception());
+            break;
+        }
+        lock.lock();
+
+        // room in the window
+        ++delivered_;
+        cond_.notify_all();
+    }
+
+    delivering_ = false;
+    cond_.notify_all();
+}
+
+template <typename Generator, typename Call, typename Sink>
+void StreamMap<Generator, Call, Sink>::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]() { return finished(); });
+    if (error_) { std::rethrow_exception(error_); }
+}
+
 } } // namespace utility::detail
 
 #endif // shared_utility_detail_map_hpp_included_
@@ -24,6 +24,7 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include <cerrno>
+#include <cstdio>
 #include <memory>
 #include <system_error>
 
@@ -35,6 +36,32 @@
 
 namespace utility {
 
+namespace {
+
+/** Reads MemAvailable from /proc/meminfo, returns 0 if not available (old
+ *  kernels).
+ */
+std::size_t memAvailable()
+{
+    std::FILE *f(std::fopen("/proc/meminfo", "re"));
+    if (!f) { return 0; }
+
+    std::size_t available(0);
+    char line[256];
+    while (std::fgets(line, sizeof(line), f)) {
+        unsigned long long kb;
+        if (std::sscanf(line, "MemAvailable: %llu kB", &kb) == 1) {
+            available = std::size_t(kb) << 10;
+            break;
+        }
+    }
+
+    std::fclose(f);
+    return available;
+}
+
+} // namespace
+
 MemInfo meminfo()
 {
     struct ::sysinfo si;
@@ -46,15 +73,18 @@ MemInfo meminfo()
         throw e;
     }
 
+    const std::size_t unit(si.mem_unit ? si.mem_unit : 1);
+
     return {
         {
-            std::size_t(si.totalram)
-            , std::size_t(si.freeram)
-            , std::size_t(si.bufferram)
+            std::size_t(si.totalram) * unit
+            , std::size_t(si.freeram) * unit
+            , std::size_t(si.bufferram) * unit
+            , memAvailable()
         }, {
-            std::size_t(si.totalswap)
-            , std::size_t(si.freeswap)
-            , 0
+            std::size_t(si.totalswap) * unit
+            , std::size_t(si.freeswap) * unit
+            , 0, 0
         }
     };
 }
@@ -0,0 +1,401 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#  include <malloc.h>
+#endif
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <system_error>
+
+#include "dbglog/dbglog.hpp"
+
+#include "../memorypressure.hpp"
+#include "../filedes.hpp"
+#include "../thread.hpp"
+
+namespace utility {
+
+namespace {
+
+/** Reads small file into string. Returns false on failure.
+ */
+bool readFile(const std::string &path, std::string &content)
+{
+    Filedes fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (!fd) { return false; }
+
+    content.clear();
+    char buffer[1024];
+    for (;;) {
+        const auto bytes(TEMP_FAILURE_RETRY
+                         (::read(fd, buffer, sizeof(buffer))));
+        if (bytes < 0) { return false; }
+        if (!bytes) { return true; }
+        content.append(buffer, bytes);
+    }
+}
+
+/** Returns path to cgroup v2 directory of this process (empty if none).
+ */
+std::string cgroupPath()
+{
+    std::string content;
+    if (!readFile("/proc/self/cgroup", content)) { return {}; }
+
+    // cgroup v2 entry: "0::/path"
+    const auto text("\n" + content);
+    auto start(text.find("\n0::"));
+    if (start == std::string::npos) { return {}; }
+    start += 4;
+    const auto end(text.find('\n', start));
+    return "/sys/fs/cgroup" + text.substr(start, end - start);
+}
+
+/** Parses number from cgroup file; "max" (and failure) means 0.
+ */
+std::size_t cgroupValue(const std::string &path)
+{
+    std::string content;
+    if (!readFile(path, content)) { return 0; }
+    unsigned long long value;
+    if (std::sscanf(content.c_str(), "%llu", &value) != 1) { return 0; }
+    return value;
+}
+
+/** Parses avg10 values from PSI file.
+ */
+void psiValues(const std::string &path, MemoryPressure &pressure)
+{
+    std::string content;
+    if (!readFile(path, content)) { return; }
+
+    const auto *p(content.c_str());
+    while (*p) {
+        double avg10;
+        if (std::sscanf(p, "some avg10=%lf", &avg10) == 1) {
+            pressure.someAvg10 = avg10;
+        } else if (std::sscanf(p, "full avg10=%lf", &avg10) == 1) {
+            pressure.fullAvg10 = avg10;
+        }
+
+        p = std::strchr(p, '\n');
+        if (!p) { break; }
+        ++p;
+    }
+}
+
+/** PSI file for this process: cgroup's memory.pressure or system-wide one.
+ */
+std::string psiPath(const std::string &cgroup)
+{
+    if (!cgroup.empty()) {
+        const auto path(cgroup + "/memory.pressure");
+        if (!::access(path.c_str(), R_OK)) { return path; }
+    }
+    return "/proc/pressure/memory";
+}
+
+MemoryPressure read(const std::string &cgroup)
+{
+    MemoryPressure pressure;
+    pressure.meminfo = meminfo();
+    if (!cgroup.empty()) {
+        pressure.cgroupLimit = cgroupValue(cgroup + "/memory.max");
+        pressure.cgroupUsage = cgroupValue(cgroup + "/memory.current");
+    }
+    psiValues(psiPath(cgroup), pressure);
+    return pressure;
+}
+
+} // namespace
+
+std::size_t MemoryPressure::limit() const
+{
+    if (cgroupLimit) {
+        return std::min(cgroupLimit, meminfo.ram.total);
+    }
+    return meminfo.ram.total;
+}
+
+std::size_t MemoryPressure::available() const
+{
+    auto available(meminfo.ram.available());
+    if (cgroupLimit) {
+        const auto left((cgroupUsage < cgroupLimit)
+                        ? (cgroupLimit - cgroupUsage) : 0);
+        available = std::min(available, left);
+    }
+    return available;
+}
+
+MemoryPressure MemoryPressure::read()
+{
+    return utility::read(cgroupPath());
+}
+
+struct MemoryPressureMonitor::Detail {
+    Detail(const Config &config);
+    ~Detail();
+
+    void run();
+
+    /** Reads state and notifies subscribers if needed.
+     */
+    void check(bool triggered);
+
+    MemoryPressure::Level level(const MemoryPressure &pressure) const;
+
+    const Config config;
+    const std::string cgroup;
+
+    /** PSI trigger; invalid if not available.
+     */
+    Filedes psi;
+
+    /** Wake-up pipe.
+     */
+    Filedes wakeRead;
+    Filedes wakeWrite;
+
+    mutable std::mutex mutex;
+
+    /** Held while subscribers are being notified.
+     */
+    std::mutex notifyMutex;
+
+    std::map<Subscription, Callback> subscribers;
+    Subscription nextSubscription;
+    MemoryPressure current;
+
+    /** Level of last notification (none after pressure went away) and its
+     *  time.
+     */
+    MemoryPressure::Level notified;
+    std::chrono::steady_clock::time_point notifiedAt;
+
+    std::atomic<bool> running;
+    std::thread thread;
+};
+
+MemoryPressureMonitor::Detail::Detail(const Config &config)
+    : config(config), cgroup(cgroupPath()), nextSubscription()
+    , notified(MemoryPressure::Level::none), running(true)
+{
+    int pipe[2];
+    if (-1 == ::pipe2(pipe, O_CLOEXEC | O_NONBLOCK)) {
+        std::system_error e(errno, std::system_category());
+        LOG(err2) << "Cannot create pipe: <" << e.code() << ", "
+                  << e.what() << ">.";
+        throw e;
+    }
+    wakeRead = Filedes(pipe[0]);
+    wakeWrite = Filedes(pipe[1]);
+
+    // register PSI trigger
+    const auto path(psiPath(cgroup));
+    Filedes fd(::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC));
+    if (fd) {
+        char trigger[64];
+        const auto size
+            (std::snprintf(trigger, sizeof(trigger), "some %lld %lld"
+                           , static_cast<long long>(config.psiStall.count())
+                           , static_cast<long long>
+                           (config.psiWindow.count())));
+        if (::write(fd, trigger, size + 1) >= 0) {
+            psi = std::move(fd);
+        } else {
+            LOG(warn2) << "Cannot register PSI trigger in " << path
+                       << ": " << std::strerror(errno)
+                       << "; falling back to polling.";
+        }
+    } else {
+        LOG(info2) << "PSI not available (" << path
+                   << "); falling back to polling.";
+    }
+
+    current = utility::read(cgroup);
+    current.level = level(current);
+
+    thread = std::thread(&Detail::run, this);
+}
+
+MemoryPressureMonitor::Detail::~Detail()
+{
+    running = false;
+    char c(0);
+    if (::write(wakeWrite, &c, 1) < 0) {}
+    thread.join();
+}
+
+MemoryPressure::Level
+MemoryPressureMonitor::Detail::level(const MemoryPressure &pressure) const
+{
+    const double limit(pressure.limit());
+    if (!limit) { return MemoryPressure::Level::none; }
+
+    const auto available(pressure.available() / limit);
+    if (available < config.critical) {
+        return MemoryPressure::Level::critical;
+    }
+    if ((available < config.moderate) || pressure.triggered) {
+        return MemoryPressure::Level::moderate;
+    }
+    return MemoryPressure::Level::none;
+}
+
+void MemoryPressureMonitor::Detail::check(bool triggered)
+{
+    MemoryPressure pressure;
+    try {
+        pressure = utility::read(cgroup);
+    } catch (const std::exception &e) {
+        LOG(warn2) << "Cannot read memory state: " << e.what() << ".";
+        return;
+    }
+    pressure.triggered = triggered;
+    pressure.level = level(pressure);
+    const auto now(std::chrono::steady_clock::now());
+
+    std::lock_guard<std::mutex> notifyLock(notifyMutex);
+    std::map<Subscription, Callback> subscribers;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = pressure;
+        if (pressure.level == MemoryPressure::Level::none) {
+            notified = MemoryPressure::Level::none;
+            return;
+        }
+
+        // notify when level rises, otherwise once per repeat period
+        if ((pressure.level <= notified)
+            && ((now - notifiedAt) < config.repeat))
+        {
+            return;
+        }
+        notified = pressure.level;
+        notifiedAt = now;
+        subscribers = this->subscribers;
+    }
+
+    LOG(info3) << "Memory pressure <"
+               << ((pressure.level == MemoryPressure::Level::critical)
+                   ? "critical" : "moderate")
+               << ">: available " << pressure.available() << " of "
+               << pressure.limit() << " bytes, PSI some avg10 "
+               << pressure.someAvg10 << "%.";
+
+    for (const auto &subscriber : subscribers) {
+        try {
+            subscriber.second(pressure);
+        } catch (const std::exception &e) {
+            LOG(warn2) << "Memory pressure subscriber failed: "
+                       << e.what() << ".";
+        }
+    }
+
+#ifdef __GLIBC__
+    if (config.mallocTrim) { ::malloc_trim(0); }
+#endif
+}
+
+void MemoryPressureMonitor::Detail::run()
+{
+    thread::setName("mempressure");
+
+    ::pollfd fds[2];
+    fds[0].fd = wakeRead;
+    fds[0].events = POLLIN;
+    fds[1].fd = psi ? int(psi) : -1;
+    fds[1].events = POLLPRI;
+
+    const int timeout(config.interval.count());
+    while (running) {
+        fds[0].revents = fds[1].revents = 0;
+        const auto res(::poll(fds, 2, timeout));
+        if (res < 0) {
+            if (errno == EINTR) { continue; }
+            std::system_error e(errno, std::system_category());
+            LOG(err2) << "Memory pressure poll failed: <" << e.code()
+                      << ", " << e.what() << ">.";
+            return;
+        }
+
+        if (!running) { break; }
+
+        if (fds[1].revents & POLLERR) {
+            LOG(warn2) << "PSI trigger gone; falling back to polling.";
+            fds[1].fd = -1;
+        }
+
+        check(fds[1].revents & POLLPRI);
+    }
+}
+
+MemoryPressureMonitor::MemoryPressureMonitor(const Config &config)
+    : detail_(new Detail(config))
+{}
+
+MemoryPressureMonitor::~MemoryPressureMonitor() {}
+
+MemoryPressureMonitor::Subscription
+MemoryPressureMonitor::subscribe(const Callback &callback)
+{
+    auto &d(*detail_);
+    std::lock_guard<std::mutex> lock(d.mutex);
+    const auto subscription(++d.nextSubscription);
+    d.subscribers.insert(std::make_pair(subscription, callback));
+    return subscription;
+}
+
+void MemoryPressureMonitor::unsubscribe(Subscription subscription)
+{
+    auto &d(*detail_);
+    // wait for running notification
+    std::lock_guard<std::mutex> notifyLock(d.notifyMutex);
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.subscribers.erase(subscription);
+}
+
+MemoryPressure MemoryPressureMonitor::current() const
+{
+    auto &d(*detail_);
+    std::lock_guard<std::mutex> lock(d.mutex);
+    return d.current;
+}
+
+} // namespace utility
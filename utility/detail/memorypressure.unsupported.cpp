@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdexcept>
+
+#include "dbglog/dbglog.hpp"
+
+#include "../memorypressure.hpp"
+
+namespace utility {
+
+std::size_t MemoryPressure::limit() const
+{
+    return meminfo.ram.total;
+}
+
+std::size_t MemoryPressure::available() const
+{
+    return meminfo.ram.available();
+}
+
+MemoryPressure MemoryPressure::read()
+{
+    LOGTHROW(err2, std::runtime_error)
+        << "Memory pressure unsupported on this platform.";
+    throw;
+}
+
+struct MemoryPressureMonitor::Detail {};
+
+MemoryPressureMonitor::MemoryPressureMonitor(const Config&)
+{
+    LOGTHROW(err2, std::runtime_error)
+        << "MemoryPressureMonitor unsupported on this platform.";
+}
+
+MemoryPressureMonitor::~MemoryPressureMonitor() {}
+
+MemoryPressureMonitor::Subscription
+MemoryPressureMonitor::subscribe(const Callback&)
+{
+    LOGTHROW(err2, std::runtime_error)
+        << "MemoryPressureMonitor unsupported on this platform.";
+    throw;
+}
+
+void MemoryPressureMonitor::unsubscribe(Subscription) {}
+
+MemoryPressure MemoryPressureMonitor::current() const
+{
+    LOGTHROW(err2, std::runtime_error)
+        << "MemoryPressureMonitor unsupported on this platform.";
+    throw;
+}
+
+} // namespace utility
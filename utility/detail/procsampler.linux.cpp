@@ -0,0 +1,516 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/types.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <map>
+#include <ostream>
+#include <system_error>
+
+#include "dbglog/dbglog.hpp"
+
+#include "../procsampler.hpp"
+#include "../filedes.hpp"
+
+namespace utility {
+
+std::size_t ProcStat::ClocksPerSecond(::sysconf(_SC_CLK_TCK));
+
+namespace {
+
+const std::size_t pageSizeKb(::sysconf(_SC_PAGESIZE) >> 10);
+
+typedef std::chrono::steady_clock Clock;
+
+Filedes openProc(ProcStat::Pid pid, const char *file)
+{
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%ld/%s", pid, file);
+    return Filedes(::open(path, O_RDONLY | O_CLOEXEC));
+}
+
+/** Reads whole (small) file into buffer. Returns number of read bytes or -1
+ *  on error. Data are null terminated.
+ */
+ssize_t readProc(const Filedes &fd, char *buffer, std::size_t size)
+{
+    const auto bytes(TEMP_FAILURE_RETRY(::pread(fd, buffer, size - 1, 0)));
+    if (bytes < 0) { return bytes; }
+    buffer[bytes] = '\0';
+    return bytes;
+}
+
+/** Parses next whitespace separated number.
+ */
+long long number(const char *&p)
+{
+    while (*p == ' ') { ++p; }
+    bool negative(false);
+    if (*p == '-') { negative = true; ++p; }
+    long long value(0);
+    for (; (*p >= '0') && (*p <= '9'); ++p) { value = value * 10 + (*p - '0'); }
+    return negative ? -value : value;
+}
+
+/** Skips given number of whitespace separated fields.
+ */
+void skip(const char *&p, int count)
+{
+    while (count-- > 0) {
+        while (*p == ' ') { ++p; }
+        while (*p && (*p != ' ')) { ++p; }
+    }
+}
+
+/** Finds number after given label in status file.
+ */
+std::size_t statusValue(const char *status, const char *label)
+{
+    const char *p(std::strstr(status, label));
+    if (!p) { return 0; }
+    p += std::strlen(label);
+    while (*p == '\t') { ++p; }
+    return number(p);
+}
+
+struct Proc {
+    Filedes stat;
+    Filedes statm;
+    Filedes status;
+    Filedes children;
+
+    long long startTime;
+    std::size_t lastTicks;
+    bool hasLast;
+    bool seen;
+
+    Proc() : startTime(-1), lastTicks(), hasLast(false), seen(false) {}
+};
+
+} // namespace
+
+struct ProcSampler::Detail {
+    Detail(const PidList &pids, const Config &config)
+        : config(config), roots(pids), last(Clock::now())
+    {
+        if (roots.empty()) { roots.push_back(::getpid()); }
+    }
+
+    Proc* open(ProcStat::Pid pid);
+
+    /** Reads process statistics. Returns false if process is gone.
+     */
+    bool read(ProcStat::Pid pid, Proc &proc, Sample &sample
+              , double elapsed);
+
+    /** Appends children of given process to the queue.
+     */
+    void children(const Proc &proc);
+
+    const Config config;
+    PidList roots;
+    std::map<ProcStat::Pid, Proc> procs;
+    Sample::list samples;
+    PidList queue;
+    Clock::time_point last;
+};
+
+Proc* ProcSampler::Detail::open(ProcStat::Pid pid)
+{
+    auto fprocs(procs.find(pid));
+    if (fprocs != procs.end()) { return &fprocs->second; }
+
+    Proc proc;
+    proc.stat = openProc(pid, "stat");
+    if (!proc.stat) { return nullptr; }
+    proc.statm = openProc(pid, "statm");
+    if (!proc.statm) { return nullptr; }
+    if (config.swap) {
+        proc.status = openProc(pid, "status");
+        if (!proc.status) { return nullptr; }
+    }
+    if (config.tree) {
+        char file[64];
+        std::snprintf(file, sizeof(file), "task/%ld/children", pid);
+        // optional, needs CONFIG_PROC_CHILDREN
+        proc.children = openProc(pid, file);
+    }
+
+    return &procs.insert(std::make_pair(pid, std::move(proc)))
+        .first->second;
+}
+
+bool ProcSampler::Detail::read(ProcStat::Pid pid, Proc &proc
+                               , Sample &sample, double elapsed)
+{
+    char buffer[1024];
+
+    // stat: pid (comm) state ppid ...; comm can contain anything
+    if (readProc(proc.stat, buffer, sizeof(buffer)) <= 0) { return false; }
+    const char *p(std::strrchr(buffer, ')'));
+    if (!p) { return false; }
+    ++p;
+
+    auto &ps(sample.stat);
+    ps.pid = pid;
+    skip(p, 1); // state
+    ps.ppid = number(p);
+    skip(p, 9); // pgrp ... cmajflt
+    ps.utime = number(p);
+    ps.stime = number(p);
+    ps.cutime = number(p);
+    ps.cstime = number(p);
+    skip(p, 4); // priority ... itrealvalue
+    const auto startTime(number(p));
+    ps.virt = number(p) >> 10;
+
+    // statm: size resident shared ... [pages]
+    if (readProc(proc.statm, buffer, sizeof(buffer)) <= 0) { return false; }
+    p = buffer;
+    skip(p, 1);
+    ps.rss = number(p) * pageSizeKb;
+    ps.shared = number(p) * pageSizeKb;
+
+    ps.swap = 0;
+    if (proc.status) {
+        char status[4096];
+        if (readProc(proc.status, status, sizeof(status)) <= 0) {
+            return false;
+        }
+        ps.swap = statusValue(status, "VmSwap:");
+    }
+
+    // same pid but different process
+    if (startTime != proc.startTime) {
+        proc.startTime = startTime;
+        proc.hasLast = false;
+    }
+
+    const auto ticks(ps.utime + ps.stime);
+    sample.cpu = -1.0;
+    if (proc.hasLast && (elapsed > 0) && (ticks >= proc.lastTicks)) {
+        sample.cpu = (100.0 * (ticks - proc.lastTicks)
+                      / ProcStat::ClocksPerSecond / elapsed);
+    }
+    proc.lastTicks = ticks;
+    proc.hasLast = true;
+
+    return true;
+}
+
+void ProcSampler::Detail::children(const Proc &proc)
+{
+    if (!proc.children) { return; }
+
+    char buffer[1024];
+    off_t offset(0);
+    for (;;) {
+        const auto bytes(TEMP_FAILURE_RETRY
+                         (::pread(proc.children, buffer, sizeof(buffer) - 1
+                                  , offset)));
+        if (bytes <= 0) { return; }
+        buffer[bytes] = '\0';
+
+        // do not split pid at buffer boundary
+        auto end(bytes);
+        if (bytes == ssize_t(sizeof(buffer) - 1)) {
+            while (end && (buffer[end - 1] != ' ')) { --end; }
+            if (!end) { return; }
+            buffer[end] = '\0';
+        }
+
+        for (const char *p(buffer); *p; ) {
+            const auto pid(number(p));
+            if (pid > 0) { queue.push_back(pid); }
+            while (*p == ' ') { ++p; }
+        }
+
+        if (end == bytes) { return; }
+        offset += end;
+    }
+}
+
+ProcSampler::ProcSampler(const PidList &pids, const Config &config)
+    : detail_(new Detail(pids, config))
+{}
+
+ProcSampler::~ProcSampler() {}
+
+const ProcSampler::Sample::list& ProcSampler::sample()
+{
+    auto &d(*detail_);
+
+    const auto now(Clock::now());
+    const auto elapsed(std::chrono::duration<double>(now - d.last).count());
+    d.last = now;
+
+    for (auto &item : d.procs) { item.second.seen = false; }
+
+    d.samples.clear();
+    d.queue.assign(d.roots.begin(), d.roots.end());
+    for (std::size_t i(0); i < d.queue.size(); ++i) {
+        const auto pid(d.queue[i]);
+        auto *proc(d.open(pid));
+        if (!proc || proc->seen) { continue; }
+
+        d.samples.emplace_back();
+        if (!d.read(pid, *proc, d.samples.back(), elapsed)) {
+            d.samples.pop_back();
+            continue;
+        }
+        proc->seen = true;
+
+        if (d.config.tree) { d.children(*proc); }
+    }
+
+    // forget vanished processes
+    for (auto iprocs(d.procs.begin()); iprocs != d.procs.end(); ) {
+        if (iprocs->second.seen) {
+            ++iprocs;
+        } else {
+            iprocs = d.procs.erase(iprocs);
+        }
+    }
+
+    return d.samples;
+}
+
+ProcSampler::Sample ProcSampler::total() const
+{
+    Sample total;
+    auto &ps(total.stat);
+    ps.pid = detail_->roots.front();
+    ps.ppid = 0;
+    ps.rss = ps.virt = ps.swap = ps.shared = 0;
+    ps.utime = ps.stime = ps.cutime = ps.cstime = 0;
+    total.cpu = -1.0;
+
+    for (const auto &sample : detail_->samples) {
+        const auto &s(sample.stat);
+        ps.rss += s.rss;
+        ps.virt += s.virt;
+        ps.swap += s.swap;
+        ps.shared += s.shared;
+        ps.utime += s.utime;
+        ps.stime += s.stime;
+        ps.cutime += s.cutime;
+        ps.cstime += s.cstime;
+
+        if (sample.cpu >= 0) {
+            total.cpu = std::max(total.cpu, 0.0) + sample.cpu;
+        }
+    }
+
+    return total;
+}
+
+// thread sampler
+
+namespace {
+
+struct Thread {
+    Filedes stat;
+    Filedes status;
+
+    long long startTime;
+    std::size_t lastTicks;
+    bool hasLast;
+    bool seen;
+
+    Thread() : startTime(-1), lastTicks(), hasLast(false), seen(false) {}
+};
+
+} // namespace
+
+struct ThreadSampler::Detail {
+    Detail(ProcStat::Pid pid)
+        : pid(pid ? pid : ::getpid()), dir(), last(Clock::now())
+    {
+        char path[64];
+        std::snprintf(path, sizeof(path), "/proc/%ld/task", this->pid);
+        dir = ::opendir(path);
+        if (!dir) {
+            std::system_error e(errno, std::system_category());
+            LOG(err2) << "Cannot open " << path << ": <"
+                      << e.code() << ", " << e.what() << ">.";
+            throw e;
+        }
+    }
+
+    ~Detail() { ::closedir(dir); }
+
+    Thread* open(ProcStat::Pid tid);
+
+    /** Reads thread statistics. Returns false if thread is gone.
+     */
+    bool read(Thread &thread, ThreadStat &stat, double elapsed);
+
+    const ProcStat::Pid pid;
+    ::DIR *dir;
+    std::map<ProcStat::Pid, Thread> threads;
+    ThreadStat::list stats;
+    Clock::time_point last;
+};
+
+Thread* ThreadSampler::Detail::open(ProcStat::Pid tid)
+{
+    auto fthreads(threads.find(tid));
+    if (fthreads != threads.end()) { return &fthreads->second; }
+
+    char file[64];
+    Thread thread;
+    std::snprintf(file, sizeof(file), "task/%ld/stat", tid);
+    thread.stat = openProc(pid, file);
+    if (!thread.stat) { return nullptr; }
+    std::snprintf(file, sizeof(file), "task/%ld/status", tid);
+    thread.status = openProc(pid, file);
+    if (!thread.status) { return nullptr; }
+
+    return &threads.insert(std::make_pair(tid, std::move(thread)))
+        .first->second;
+}
+
+bool ThreadSampler::Detail::read(Thread &thread, ThreadStat &stat
+                                 , double elapsed)
+{
+    char buffer[4096];
+
+    // stat: tid (comm) state ppid ...
+    if (readProc(thread.stat, buffer, sizeof(buffer)) <= 0) { return false; }
+    const char *open(std::strchr(buffer, '('));
+    const char *p(std::strrchr(buffer, ')'));
+    if (!open || !p || (p < open)) { return false; }
+    stat.name.assign(open + 1, p);
+    ++p;
+
+    skip(p, 11); // state ... cmajflt
+    stat.utime = number(p);
+    stat.stime = number(p);
+    skip(p, 6); // cutime ... itrealvalue
+    const auto startTime(number(p));
+
+    if (readProc(thread.status, buffer, sizeof(buffer)) <= 0) {
+        return false;
+    }
+    stat.voluntarySwitches = statusValue(buffer, "voluntary_ctxt_switches:");
+    stat.involuntarySwitches
+        = statusValue(buffer, "nonvoluntary_ctxt_switches:");
+
+    // same tid but different thread
+    if (startTime != thread.startTime) {
+        thread.startTime = startTime;
+        thread.hasLast = false;
+    }
+
+    const auto ticks(stat.utime + stat.stime);
+    stat.cpu = -1.0;
+    if (thread.hasLast && (elapsed > 0) && (ticks >= thread.lastTicks)) {
+        stat.cpu = (100.0 * (ticks - thread.lastTicks)
+                    / ProcStat::ClocksPerSecond / elapsed);
+    }
+    thread.lastTicks = ticks;
+    thread.hasLast = true;
+
+    return true;
+}
+
+ThreadSampler::ThreadSampler(ProcStat::Pid pid)
+    : detail_(new Detail(pid))
+{}
+
+ThreadSampler::~ThreadSampler() {}
+
+const ThreadStat::list& ThreadSampler::sample()
+{
+    auto &d(*detail_);
+
+    const auto now(Clock::now());
+    const auto elapsed(std::chrono::duration<double>(now - d.last).count());
+    d.last = now;
+
+    for (auto &item : d.threads) { item.second.seen = false; }
+
+    // reuse existing entries (and their name buffers)
+    std::size_t count(0);
+    ::rewinddir(d.dir);
+    while (const auto *entry = ::readdir(d.dir)) {
+        const char *p(entry->d_name);
+        const auto tid(number(p));
+        if ((tid <= 0) || *p) { continue; }
+
+        auto *thread(d.open(tid));
+        if (!thread) { continue; }
+
+        if (count == d.stats.size()) { d.stats.emplace_back(); }
+        auto &stat(d.stats[count]);
+        stat.tid = tid;
+        if (!d.read(*thread, stat, elapsed)) { continue; }
+        thread->seen = true;
+        ++count;
+    }
+    d.stats.resize(count);
+
+    // forget finished threads
+    for (auto ithreads(d.threads.begin()); ithreads != d.threads.end(); ) {
+        if (ithreads->second.seen) {
+            ++ithreads;
+        } else {
+            ithreads = d.threads.erase(ithreads);
+        }
+    }
+
+    return d.stats;
+}
+
+void ThreadSampler::report(std::ostream &os, const std::string &name
+                           , std::size_t top) const
+{
+    std::vector<const ThreadStat*> sorted;
+    sorted.reserve(detail_->stats.size());
+    for (const auto &stat : detail_->stats) { sorted.push_back(&stat); }
+    std::sort(sorted.begin(), sorted.end()
+              , [](const ThreadStat *l, const ThreadStat *r)
+    {
+        return l->cpu > r->cpu;
+    });
+
+    if (top && (sorted.size() > top)) { sorted.resize(top); }
+
+    for (const auto *stat : sorted) {
+        os << name << stat->name << '.' << stat->tid << ".cpu="
+           << std::max(stat->cpu, 0.0) << '\n';
+    }
+}
+
+} // namespace utility
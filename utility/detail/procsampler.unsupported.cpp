@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdexcept>
+
+#include "dbglog/dbglog.hpp"
+
+#include "../procsampler.hpp"
+
+namespace utility {
+
+struct ProcSampler::Detail {};
+
+ProcSampler::ProcSampler(const PidList&, const Config&)
+{
+    LOGTHROW(err2, std::runtime_error)
+        << "ProcSampler unsupported on this platform.";
+}
+
+ProcSampler::~ProcSampler() {}
+
+const ProcSampler::Sample::list& ProcSampler::sample()
+{
+    LOGTHROW(err2, std::runtime_error)
+        << "ProcSampler unsupported on this platform.";
+    throw;
+}
+
+ProcSampler::Sample ProcSampler::total() const
+{
+    LOGTHROW(err2, std::runtime_error)
+        << "ProcSampler unsupported on this platform.";
+    throw;
+}
+
+struct ThreadSampler::Detail {};
+
+ThreadSampler::ThreadSampler(ProcStat::Pid)
+{
+    LOGTHROW(err2, std::runtime_error)
+        << "ThreadSampler unsupported on this platform.";
+}
+
+ThreadSampler::~ThreadSampler() {}
+
+const ThreadStat::list& ThreadSampler::sample()
+{
+    LOGTHROW(err2, std::runtime_error)
+        << "ThreadSampler unsupported on this platform.";
+    throw;
+}
+
+void ThreadSampler::report(std::ostream&, const std::string&
+                           , std::size_t) const
+{
+    LOGTHROW(err2, std::runtime_error)
+        << "ThreadSampler unsupported on this platform.";
+}
+
+} // namespace utility
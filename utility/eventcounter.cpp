@@ -24,6 +24,11 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <time.h>
+
+#include <thread>
+#include <algorithm>
+
 #include "dbglog/dbglog.hpp"
 
 #include "eventcounter.hpp"
@@ -177,4 +182,170 @@ void EventCounter::averageAndMax(std::ostream &os, const std::string &name
     }
 }
 
+// sharded event counter
+
+ShardedEventCounter::Counts ShardedEventCounter::standardTimes{5, 60, 300};
+
+namespace {
+
+std::size_t threadIndex()
+{
+    static std::atomic<std::size_t> next(0);
+    thread_local std::size_t index(next++);
+    return index;
+}
+
+/** Milliseconds from unspecified point in time. Coarse (few ms resolution)
+ *  but very cheap.
+ */
+std::uint64_t coarseMs()
+{
+#ifdef CLOCK_MONOTONIC_COARSE
+    struct ::timespec ts;
+    if (!::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts)) {
+        return (std::uint64_t(ts.tv_sec) * 1000
+                + std::uint64_t(ts.tv_nsec) / 1000000);
+    }
+#endif
+    return std::chrono::duration_cast<std::chrono::milliseconds>
+        (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+ShardedEventCounter::ShardedEventCounter(int size, Resolution resolution
+                                         , std::size_t shards)
+    : size_(std::max(size, 2))
+    , resolution_(std::max<std::uint64_t>(resolution.count(), 1))
+    , shards_(shards ? shards
+              : std::max(std::thread::hardware_concurrency(), 1u))
+      // round up to whole cache lines (8 slots) + one line of padding
+    , stride_(((size_ + 7) & ~std::size_t(7)) + 8)
+    , slots_(new Slot[shards_ * stride_])
+{
+    for (std::size_t i(0), e(shards_ * stride_); i != e; ++i) {
+        slots_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+std::uint64_t ShardedEventCounter::tick() const
+{
+    // + 1: tick 0 is reserved for empty slots
+    return coarseMs() / resolution_ + 1;
+}
+
+void ShardedEventCounter::event(std::size_t count)
+{
+    const auto now(tick());
+    const auto nowTag(tag(now));
+    auto &s(slot(threadIndex() % shards_, now));
+
+    // shards are (mostly) thread-private, the loop rarely spins
+    auto value(s.load(std::memory_order_relaxed));
+    for (;;) {
+        const auto next((((value & ~CountMask) == nowTag)
+                         ? value : nowTag) + count);
+        if (s.compare_exchange_weak(value, next, std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
+
+std::tuple<std::size_t, double>
+ShardedEventCounter::window(std::size_t count) const
+{
+    // limit to count to the number of slots, ignore current slot
+    auto slots((count * 1000 + resolution_ - 1) / resolution_);
+    if (!slots) { slots = 1; }
+    if ((slots + 1) >= size_) { slots = size_ - 1; }
+    return std::tuple<std::size_t, double>
+        (slots, (slots * resolution_) / 1000.0);
+}
+
+template <typename F>
+void ShardedEventCounter::processBlock(std::size_t slots, const F &f) const
+{
+    const auto now(tick());
+    for (auto t(now - std::min<std::uint64_t>(slots, now - 1)); t < now; ++t)
+    {
+        const auto t_(tag(t));
+        std::size_t sum(0);
+        for (std::size_t shard(0); shard < shards_; ++shard) {
+            const auto value(slot(shard, t).load(std::memory_order_relaxed));
+            if ((value & ~CountMask) == t_) { sum += (value & CountMask); }
+        }
+        f(sum);
+    }
+}
+
+double ShardedEventCounter::average(std::size_t count) const
+{
+    return std::get<0>(averageAndMax(count));
+}
+
+std::size_t ShardedEventCounter::max(std::size_t count) const
+{
+    return std::get<1>(averageAndMax(count));
+}
+
+std::size_t ShardedEventCounter::total(std::size_t count) const
+{
+    std::size_t total(0);
+    processBlock(std::get<0>(window(count))
+                 , [&total](std::size_t value) { total += value; });
+    return total;
+}
+
+std::tuple<double, std::size_t>
+ShardedEventCounter::averageAndMax(std::size_t count) const
+{
+    const auto w(window(count));
+    double total(.0);
+    std::size_t max(0);
+
+    processBlock
+        (std::get<0>(w), [&total, &max](std::size_t value) {
+            total += value;
+            if (value > max) { max = value; }
+        });
+
+    return std::tuple<double, std::size_t>(total / std::get<1>(w), max);
+}
+
+void ShardedEventCounter::average(std::ostream &os, const std::string &name
+                                  , const Counts &counts) const
+{
+    for (auto count : counts) {
+        os << name << "avg." << count << '=' << average(count) << '\n';
+    }
+}
+
+void ShardedEventCounter::total(std::ostream &os, const std::string &name
+                                , const Counts &counts) const
+{
+    for (auto count : counts) {
+        os << name << "total." << count << '=' << total(count) << '\n';
+    }
+}
+
+void ShardedEventCounter::max(std::ostream &os, const std::string &name
+                              , const Counts &counts) const
+{
+    for (auto count : counts) {
+        os << name << "max." << count << '=' << max(count) << '\n';
+    }
+}
+
+void ShardedEventCounter::averageAndMax(std::ostream &os
+                                        , const std::string &name
+                                        , const Counts &counts) const
+{
+    for (auto count : counts) {
+        const auto am(averageAndMax(count));
+        os << name << "avg." << count << '=' << std::get<0>(am) << '\n';
+        os << name << "max." << count << '=' << std::get<1>(am) << '\n';
+    }
+}
+
 } // namespace utility
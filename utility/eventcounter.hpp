@@ -28,8 +28,15 @@
 #define utility_eventcounter_hpp_included_
 
 #include <ctime>
+#include <cstdint>
+#include <chrono>
+#include <atomic>
 #include <vector>
 #include <mutex>
+#include <memory>
+#include <tuple>
+#include <iosfwd>
+#include <string>
 
 namespace utility {
 
@@ -124,6 +131,125 @@ private:
     static Counts standardTimes;
 };
 
+/** Contention-free variant of EventCounter for hot paths.
+ *
+ *  Events are recorded into per-thread shards (threads are assigned to shards
+ *  round-robin) of slot arrays using relaxed atomics; no lock is ever taken.
+ *  Shards are aggregated only when read. Slot width (resolution) is
+ *  configurable, e.g. 100 ms to reveal short spikes, and time is measured by
+ *  a cheap coarse monotonic clock.
+ *
+ *  Reporting interface is the same as of EventCounter: windows are given in
+ *  seconds and averages are per second. Maximum is maximum per slot.
+ *
+ *  There is no eventMax(): per-shard maxima cannot be combined with sums.
+ */
+class ShardedEventCounter {
+public:
+    typedef std::chrono::milliseconds Resolution;
+    typedef EventCounter::Counts Counts;
+
+    /** Create event counter with given number of slots, each spanning given
+     *  time. Number of shards defaults to number of CPUs.
+     */
+    ShardedEventCounter(int size
+                        , Resolution resolution = std::chrono::seconds(1)
+                        , std::size_t shards = 0);
+
+    /** Record event in the current slot. Can be used to report multiple events
+     *  at once. Lock-free.
+     */
+    void event(std::size_t count = 1);
+
+    /** Returns event average per second over given second window. Current
+     *  slot is ignored.
+     *
+     *  If there is not enough slots the window is reduced.
+     */
+    double average(std::size_t count) const;
+
+    /** Returns maximum per slot in given second window. Current slot is
+     *  ignored.
+     */
+    std::size_t max(std::size_t count) const;
+
+    /** Returns event total (i.e. sum) in given second window. Current slot is
+     *  ignored.
+     */
+    std::size_t total(std::size_t count) const;
+
+    /** Returns event average and maximum in given second window. Current slot
+     *  is ignored.
+     */
+    std::tuple<double, std::size_t> averageAndMax(std::size_t count) const;
+
+    /** Reports averages to output stream.
+     */
+    void average(std::ostream &os, const std::string &name
+                 , const Counts &counts = standardTimes) const;
+
+    /** Reports total values to output stream.
+     */
+    void total(std::ostream &os, const std::string &name
+               , const Counts &counts = standardTimes) const;
+
+    /** Reports maximums to output stream.
+     */
+    void max(std::ostream &os, const std::string &name
+             , const Counts &counts = standardTimes) const;
+
+    /** Reports averages and maximums to output stream.
+     */
+    void averageAndMax(std::ostream &os, const std::string &name
+                       , const Counts &counts = standardTimes) const;
+
+    Resolution resolution() const { return Resolution(resolution_); }
+
+private:
+    /** Slot value: tick tag in upper TagBits, count in the rest. The tag
+     *  distinguishes current slot content from content left there by older
+     *  ticks.
+     */
+    typedef std::uint64_t Value;
+    typedef std::atomic<Value> Slot;
+
+    static constexpr int TagBits = 24;
+    static constexpr Value CountMask = (Value(1) << (64 - TagBits)) - 1;
+
+    /** Current tick (time / resolution).
+     */
+    std::uint64_t tick() const;
+
+    static Value tag(std::uint64_t tick) { return tick << (64 - TagBits); }
+
+    /** Converts window in seconds to number of slots. Returns (slots, real
+     *  window length in seconds).
+     */
+    std::tuple<std::size_t, double> window(std::size_t count) const;
+
+    /** Calls f(sum) for each slot in the window.
+     */
+    template <typename F>
+    void processBlock(std::size_t slots, const F &f) const;
+
+    Slot& slot(std::size_t shard, std::uint64_t tick) const {
+        return slots_[shard * stride_ + tick % size_];
+    }
+
+    std::size_t size_;
+    std::uint64_t resolution_;
+    std::size_t shards_;
+
+    /** Distance between shards; padded to keep shards on separate cache
+     *  lines.
+     */
+    std::size_t stride_;
+
+    std::unique_ptr<Slot[]> slots_;
+
+    static Counts standardTimes;
+};
+
 } // namespace utility
 
 #endif // utility_eventcounter_hpp_included_
@@ -0,0 +1,196 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <thread>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+#include "dbglog/dbglog.hpp"
+
+#include "histogram.hpp"
+
+namespace utility {
+
+constexpr int WindowedHistogram::SubBucketBits;
+constexpr int WindowedHistogram::MaxBits;
+constexpr std::size_t WindowedHistogram::BucketCount;
+
+WindowedHistogram::Counts WindowedHistogram::standardTimes{5, 60, 300};
+WindowedHistogram::Quantiles
+WindowedHistogram::standardQuantiles{.5, .99, .999};
+
+namespace {
+
+const std::uint64_t SubBuckets(1 << WindowedHistogram::SubBucketBits);
+
+/** Quantile label: 0.5 -> p50, 0.99 -> p99, 0.999 -> p999
+ */
+std::string label(double q)
+{
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(6) << (q * 100);
+    auto str(os.str());
+    while (!str.empty() && (str.back() == '0')) { str.pop_back(); }
+    if (!str.empty() && (str.back() == '.')) { str.pop_back(); }
+    str.erase(std::remove(str.begin(), str.end(), '.'), str.end());
+    return "p" + str;
+}
+
+} // namespace
+
+WindowedHistogram::Slot::Slot()
+    : when(0)
+{
+    for (auto &count : counts) { count.store(0, std::memory_order_relaxed); }
+}
+
+WindowedHistogram::WindowedHistogram(int size)
+    : size_(std::max(size, 2)), slots_(new Slot[size_])
+{}
+
+std::size_t WindowedHistogram::bucket(std::uint64_t value)
+{
+    const std::uint64_t max((std::uint64_t(1) << MaxBits) - 1);
+    if (value > max) { value = max; }
+    if (value < SubBuckets) { return value; }
+
+    // exponent: index of highest bit set (binary search over 32 bits)
+    int e(0);
+    for (int shift(MaxBits / 2); shift; shift >>= 1) {
+        if (value >> (e + shift)) { e += shift; }
+    }
+    return ((e - SubBucketBits + 1) << SubBucketBits)
+        + ((value >> (e - SubBucketBits)) - SubBuckets);
+}
+
+std::uint64_t WindowedHistogram::upperBound(std::size_t bucket)
+{
+    if (bucket < SubBuckets) { return bucket; }
+    const int shift((bucket >> SubBucketBits) - 1);
+    const std::uint64_t sub((bucket & (SubBuckets - 1)) + SubBuckets);
+    return ((sub + 1) << shift) - 1;
+}
+
+void WindowedHistogram::record(std::uint64_t value, std::uint32_t count)
+{
+    const std::int64_t now(std::time(nullptr));
+    auto &slot(slots_[now % size_]);
+
+    for (;;) {
+        auto when(slot.when.load(std::memory_order_acquire));
+        if (when == now) { break; }
+
+        if (when < 0) {
+            // being cleared
+            if (-when > now) { return; }
+            std::this_thread::yield();
+            continue;
+        }
+
+        // slot taken by future second: we are late, drop the value
+        if (when > now) { return; }
+
+        // old slot: claim and clear
+        if (slot.when.compare_exchange_weak(when, -now
+                                            , std::memory_order_acquire))
+        {
+            for (auto &c : slot.counts) {
+                c.store(0, std::memory_order_relaxed);
+            }
+            slot.when.store(now, std::memory_order_release);
+            break;
+        }
+    }
+
+    slot.counts[bucket(value)].fetch_add(count, std::memory_order_relaxed);
+}
+
+WindowedHistogram::Buckets WindowedHistogram::aggregate(std::size_t count)
+    const
+{
+    // limit to count to the number of slots, ignore current slot
+    if ((count + 1) >= size_) {
+        count = size_ - 1;
+    }
+
+    Buckets buckets(BucketCount, 0);
+
+    const std::int64_t now(std::time(nullptr));
+    for (auto time(now - std::int64_t(count)); time < now; ++time) {
+        const auto &slot(slots_[time % size_]);
+        if (slot.when.load(std::memory_order_acquire) != time) { continue; }
+
+        for (std::size_t i(0); i < BucketCount; ++i) {
+            buckets[i] += slot.counts[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    return buckets;
+}
+
+std::uint64_t WindowedHistogram::quantile(const Buckets &buckets, double q)
+{
+    std::uint64_t total(0);
+    for (auto count : buckets) { total += count; }
+    if (!total) { return 0; }
+
+    const auto limit(q * total);
+    std::uint64_t sum(0);
+    for (std::size_t i(0); i < BucketCount; ++i) {
+        sum += buckets[i];
+        if (sum && (sum >= limit)) { return upperBound(i); }
+    }
+
+    return upperBound(BucketCount - 1);
+}
+
+std::uint64_t WindowedHistogram::quantile(double q, std::size_t count) const
+{
+    return quantile(aggregate(count), q);
+}
+
+std::size_t WindowedHistogram::total(std::size_t count) const
+{
+    std::size_t total(0);
+    for (auto c : aggregate(count)) { total += c; }
+    return total;
+}
+
+void WindowedHistogram::quantiles(std::ostream &os, const std::string &name
+                                  , const Counts &counts
+                                  , const Quantiles &quantiles) const
+{
+    for (auto count : counts) {
+        const auto buckets(aggregate(count));
+        for (auto q : quantiles) {
+            os << name << label(q) << '.' << count << '='
+               << quantile(buckets, q) << '\n';
+        }
+    }
+}
+
+} // namespace utility
@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file utility/histogram.hpp
+ *
+ * Windowed log-linear histogram.
+ */
+
+#ifndef utility_histogram_hpp_included_
+#define utility_histogram_hpp_included_
+
+#include <ctime>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <iosfwd>
+#include <string>
+
+#include "eventcounter.hpp"
+
+namespace utility {
+
+/** Windowed histogram. A cyclic buffer of slots, each holding a histogram of
+ *  values recorded in particular second. Quantiles are computed over given
+ *  number of last slots, i.e. it is a percentile-reporting counterpart of
+ *  EventCounter.
+ *
+ *  Buckets are log-linear (HDR-style): each power of two range is split into
+ *  8 linear sub-buckets, i.e. relative error of reported values is at most
+ *  12.5%. Values above 2^32 - 1 are clamped.
+ *
+ *  Recording is lock-free (relaxed atomic increment); the only
+ *  synchronization happens once per second when a slot is being reused.
+ */
+class WindowedHistogram {
+public:
+    typedef EventCounter::Counts Counts;
+    typedef std::vector<double> Quantiles;
+
+    /** Create histogram with given number of (one second) slots.
+     */
+    WindowedHistogram(int size = 301);
+
+    /** Record value (in any unit, e.g. microseconds) in the current slot. Can
+     *  be used to report multiple occurrences at once.
+     *
+     *  Per-bucket counters are 32 bits wide: more than 2^32 - 1 occurrences
+     *  of values falling into the same bucket within one second wrap around.
+     */
+    void record(std::uint64_t value, std::uint32_t count = 1);
+
+    /** Returns upper bound of given quantile (0-1) over given second window.
+     *  Current slot is ignored. Returns 0 if there are no values.
+     *
+     *  If there is not enough slots the count is reduced.
+     */
+    std::uint64_t quantile(double q, std::size_t count) const;
+
+    /** Returns number of recorded values in given second window. Current slot
+     *  is ignored.
+     */
+    std::size_t total(std::size_t count) const;
+
+    /** Reports quantiles to output stream, e.g. for name "latency." and
+     *  0.99 quantile over 60 seconds: "latency.p99.60=value".
+     */
+    void quantiles(std::ostream &os, const std::string &name
+                   , const Counts &counts = standardTimes
+                   , const Quantiles &quantiles = standardQuantiles) const;
+
+    static constexpr int SubBucketBits = 3;
+    static constexpr int MaxBits = 32;
+    static constexpr std::size_t BucketCount
+        = (MaxBits - SubBucketBits + 1) << SubBucketBits;
+
+    /** Bucket index for given value.
+     */
+    static std::size_t bucket(std::uint64_t value);
+
+    /** Highest value falling into given bucket.
+     */
+    static std::uint64_t upperBound(std::size_t bucket);
+
+private:
+    typedef std::vector<std::uint64_t> Buckets;
+
+    /** Sums slots in given window.
+     */
+    Buckets aggregate(std::size_t count) const;
+
+    static std::uint64_t quantile(const Buckets &buckets, double q);
+
+    /** Histogram slot.
+     */
+    struct Slot {
+        /** Second this slot belongs to; negative while being cleared for
+         *  second -when.
+         */
+        std::atomic<std::int64_t> when;
+        std::atomic<std::uint32_t> counts[BucketCount];
+
+        Slot();
+    };
+
+    std::size_t size_;
+    std::unique_ptr<Slot[]> slots_;
+
+    /** Counts for standard times (5, 60 and 300 seconds).
+     */
+    static Counts standardTimes;
+
+    /** Standard quantiles (p50, p99, p999).
+     */
+    static Quantiles standardQuantiles;
+};
+
+} // namespace utility
+
+#endif // utility_histogram_hpp_included_
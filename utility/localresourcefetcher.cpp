@@ -0,0 +1,439 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <system_error>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/optional.hpp>
+
+#include "utility/unistd_compat.hpp"
+#include "dbglog/dbglog.hpp"
+
+#include "localresourcefetcher.hpp"
+#include "threadpool.hpp"
+#include "filesystem.hpp"
+#include "filedes.hpp"
+#include "httpcode.hpp"
+#include "uri.hpp"
+#include "zip.hpp"
+#include "tar.hpp"
+
+#ifndef O_CLOEXEC
+// not available on all platforms
+#define O_CLOEXEC 0
+#endif
+
+namespace fs = boost::filesystem;
+
+namespace utility {
+
+typedef ResourceFetcher::Query Query;
+typedef ResourceFetcher::MultiQuery MultiQuery;
+
+namespace {
+
+enum class Scheme { file, zip, tar };
+
+/** Parsed location.
+ */
+struct Location {
+    Scheme scheme;
+
+    /** File or archive path.
+     */
+    fs::path path;
+
+    /** Path inside archive.
+     */
+    fs::path member;
+};
+
+boost::optional<Location> parseLocation(const std::string &location)
+{
+    const auto parse([&](Scheme scheme, const char *prefix)
+                     -> boost::optional<Location>
+    {
+        if (!boost::algorithm::starts_with(location, prefix)) {
+            return boost::none;
+        }
+
+        const auto begin(location.begin() + std::strlen(prefix));
+        if (scheme == Scheme::file) {
+            return Location{scheme, urlDecode(begin, location.end()), {}};
+        }
+
+        const auto hash(location.rfind('#'));
+        if ((hash == std::string::npos)
+            || (hash < std::size_t(begin - location.begin())))
+        {
+            return boost::none;
+        }
+        const auto split(location.begin() + hash);
+        return Location{scheme, urlDecode(begin, split)
+                , urlDecode(split + 1, location.end())};
+    });
+
+    if (auto l = parse(Scheme::file, "file://")) { return l; }
+    if (auto l = parse(Scheme::zip, "zip://")) { return l; }
+    if (auto l = parse(Scheme::tar, "tar://")) { return l; }
+    return boost::none;
+}
+
+/** Guesses content type from file extension.
+ */
+std::string contentType(const fs::path &path)
+{
+    const std::map<std::string, std::string> types = {
+        { ".html", "text/html" }
+        , { ".txt", "text/plain" }
+        , { ".css", "text/css" }
+        , { ".js", "application/javascript" }
+        , { ".json", "application/json" }
+        , { ".xml", "application/xml" }
+        , { ".png", "image/png" }
+        , { ".jpg", "image/jpeg" }
+        , { ".jpeg", "image/jpeg" }
+    };
+
+    const auto ftypes(types.find(path.extension().string()));
+    if (ftypes == types.end()) { return "application/octet-stream"; }
+    return ftypes->second;
+}
+
+std::size_t preadAll(int fd, char *data, std::size_t size, off_t offset)
+{
+    std::size_t total(0);
+    while (size) {
+        const auto bytes(::pread(fd, data, size, offset));
+        if (bytes == -1) {
+            if (errno == EINTR) { continue; }
+            std::system_error e(errno, std::system_category());
+            LOG(err2) << "Cannot read from file: <" << e.code()
+                      << ", " << e.what() << ">.";
+            throw e;
+        }
+        if (!bytes) { break; }
+        data += bytes;
+        size -= bytes;
+        offset += bytes;
+        total += bytes;
+    }
+    return total;
+}
+
+/** Opened archive.
+ */
+struct Archive {
+    typedef std::shared_ptr<Archive> pointer;
+
+    FileStat stat;
+    std::unique_ptr<zip::Reader> zip;
+    std::unique_ptr<tar::IndexedReader> tar;
+    std::size_t lastUsed;
+
+    Archive(const FileStat &stat) : stat(stat), lastUsed() {}
+};
+
+/** One perform() call.
+ */
+struct Request {
+    MultiQuery query;
+    ResourceFetcher::Done done;
+
+    /** Number of unfinished tasks.
+     */
+    std::atomic<std::size_t> remaining;
+
+    Request(MultiQuery &&query, const ResourceFetcher::Done &done)
+        : query(std::move(query)), done(done), remaining()
+    {}
+
+    void finished() {
+        if (!--remaining) { done(std::move(query)); }
+    }
+};
+
+typedef std::vector<std::pair<std::size_t, Location>> Batch;
+
+} // namespace
+
+struct LocalResourceFetcher::Detail {
+    Detail(const Config &config)
+        : config(config)
+        , pool(config.threads
+               ? std::unique_ptr<ThreadPool>(new ThreadPool(config.threads
+                                                            , "local"))
+               : nullptr)
+        , queue(pool ? *pool : ThreadPool::shared())
+        , useCounter()
+    {}
+
+    /** Serves a batch of queries (all from the same file or archive).
+     */
+    void serve(Request &request, const Batch &batch);
+
+    void file(Query &query, const Location &location);
+
+    void member(Query &query, const Archive::pointer &archive
+                , const Location &location);
+
+    /** Returns open archive, (re)opens if needed.
+     */
+    Archive::pointer archive(const Location &location);
+
+    std::time_t expires() const {
+        if (config.maxAge < 0) { return -1; }
+        return std::time(nullptr) + config.maxAge;
+    }
+
+    const Config config;
+    std::unique_ptr<ThreadPool> pool;
+    const AsyncQueue &queue;
+
+    std::mutex mutex;
+    /** Open archives, keyed by scheme and path (the same file can be opened
+     *  both as zip and tar).
+     */
+    typedef std::pair<Scheme, fs::path> ArchiveKey;
+    std::map<ArchiveKey, Archive::pointer> archives;
+    std::size_t useCounter;
+};
+
+void LocalResourceFetcher::Detail::file(Query &query
+                                        , const Location &location)
+{
+    Filedes fd(::open(location.path.string().c_str(), O_RDONLY | O_CLOEXEC)
+               , location.path);
+    if (!fd) {
+        if (errno == ENOENT) {
+            query.error(make_error_code(HttpCode::NotFound));
+            return;
+        }
+        std::system_error e(errno, std::system_category());
+        LOG(err2) << "Cannot open file " << location.path << ": <"
+                  << e.code() << ", " << e.what() << ">.";
+        throw e;
+    }
+
+    const auto stat(FileStat::from(fd.get()));
+    std::string data(stat.size, '\0');
+    data.resize(preadAll(fd.get(), &data[0], data.size(), 0));
+
+    query.set(stat.modified, expires(), SharedBuffer(std::move(data))
+              , contentType(location.path));
+}
+
+void LocalResourceFetcher::Detail::member(Query &query
+                                          , const Archive::pointer &archive
+                                          , const Location &location)
+{
+    SharedBuffer data;
+    if (archive->zip) {
+        const auto &zip(*archive->zip);
+        const auto index(zip.tryFind(location.member));
+        if (!index) {
+            query.error(make_error_code(HttpCode::NotFound));
+            return;
+        }
+
+        const auto &record(zip.files()[*index]);
+        if (!record.header.compressionMethod) {
+            // stored file: served directly from mapped archive, mapping is
+            // kept alive by the archive itself
+            const auto mapped(zip.map(*index));
+            data = SharedBuffer(archive, mapped.data, mapped.size);
+        } else {
+            std::string tmp(record.header.uncompressedSize, '\0');
+            tmp.resize(zip.read(*index, &tmp[0], tmp.size(), 0));
+            data = SharedBuffer(std::move(tmp));
+        }
+    } else {
+        const auto *file(archive->tar->tryFind(location.member));
+        if (!file) {
+            query.error(make_error_code(HttpCode::NotFound));
+            return;
+        }
+        data = SharedBuffer(archive->tar->readData(*file));
+    }
+
+    query.set(archive->stat.modified, expires(), std::move(data)
+              , contentType(location.member));
+}
+
+Archive::pointer LocalResourceFetcher::Detail::archive(const Location &location)
+{
+    const auto stat(FileStat::from(location.path, std::nothrow));
+    if (stat.modified < 0) { return {}; }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto farchives(archives.find(ArchiveKey
+                                     (location.scheme, location.path)));
+        if ((farchives != archives.end())
+            && !farchives->second->stat.changed(stat))
+        {
+            farchives->second->lastUsed = ++useCounter;
+            return farchives->second;
+        }
+    }
+
+    // open outside of lock
+    auto archive(std::make_shared<Archive>(stat));
+    if (location.scheme == Scheme::zip) {
+        archive->zip.reset(new zip::Reader(location.path));
+    } else {
+        archive->tar.reset(new tar::IndexedReader(location.path));
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    archive->lastUsed = ++useCounter;
+    archives[ArchiveKey(location.scheme, location.path)] = archive;
+
+    // drop least recently used archives
+    while (archives.size() > std::max<std::size_t>(config.openArchives, 1)) {
+        auto lru(archives.begin());
+        for (auto i(archives.begin()), e(archives.end()); i != e; ++i) {
+            if (i->second->lastUsed < lru->second->lastUsed) { lru = i; }
+        }
+        archives.erase(lru);
+    }
+
+    return archive;
+}
+
+void LocalResourceFetcher::Detail::serve(Request &request, const Batch &batch)
+{
+    const auto &front(batch.front().second);
+
+    Archive::pointer archive;
+    if (front.scheme != Scheme::file) {
+        try {
+            archive = this->archive(front);
+        } catch (...) {
+            for (const auto &item : batch) {
+                request.query[item.first].error(std::current_exception());
+            }
+            return;
+        }
+
+        if (!archive) {
+            for (const auto &item : batch) {
+                request.query[item.first].error
+                    (make_error_code(HttpCode::NotFound));
+            }
+            return;
+        }
+    }
+
+    for (const auto &item : batch) {
+        auto &query(request.query[item.first]);
+        try {
+            if (archive) {
+                member(query, archive, item.second);
+            } else {
+                file(query, item.second);
+            }
+        } catch (...) {
+            query.error(std::current_exception());
+        }
+    }
+}
+
+LocalResourceFetcher::LocalResourceFetcher(const Config &config)
+    : detail_(std::make_shared<Detail>(config))
+{}
+
+LocalResourceFetcher::~LocalResourceFetcher()
+{
+    // finish pending tasks while we are still alive
+    if (detail_->pool) { detail_->pool->stop(); }
+}
+
+void LocalResourceFetcher::perform_impl(MultiQuery query
+                                        , const Done &done) const
+{
+    auto request(std::make_shared<Request>(std::move(query), done));
+
+    // group queries: one batch per archive, one batch per plain file
+    std::vector<Batch> batches;
+    std::map<std::pair<Scheme, fs::path>, std::size_t> archiveBatches;
+
+    const auto size(request->query.size());
+    for (std::size_t i(0); i < size; ++i) {
+        auto &q(request->query[i]);
+        auto location(parseLocation(q.location()));
+        if (!location) {
+            LOG(warn2) << "Unsupported location <" << q.location() << ">.";
+            q.error(make_error_code(HttpCode::BadRequest));
+            continue;
+        }
+
+        if (location->scheme == Scheme::file) {
+            batches.emplace_back();
+            batches.back().emplace_back(i, std::move(*location));
+            continue;
+        }
+
+        const auto key(std::make_pair(location->scheme, location->path));
+        auto fbatch(archiveBatches.find(key));
+        if (fbatch == archiveBatches.end()) {
+            fbatch = archiveBatches.insert(fbatch, {key, batches.size()});
+            batches.emplace_back();
+        }
+        batches[fbatch->second].emplace_back(i, std::move(*location));
+    }
+
+    // one extra for this call
+    request->remaining = batches.size() + 1;
+
+    auto detail(detail_);
+    for (auto &batch : batches) {
+        auto shared(std::make_shared<Batch>(std::move(batch)));
+        try {
+            detail->queue.post([detail, request, shared]()
+            {
+                detail->serve(*request, *shared);
+                request->finished();
+            });
+        } catch (...) {
+            // pool not running
+            for (const auto &item : *shared) {
+                request->query[item.first].error(std::current_exception());
+            }
+            request->finished();
+        }
+    }
+
+    request->finished();
+}
+
+} // namespace utility
@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file utility/localresourcefetcher.hpp
+ *
+ * ResourceFetcher serving local files and archive members.
+ */
+
+#ifndef utility_localresourcefetcher_hpp_included_
+#define utility_localresourcefetcher_hpp_included_
+
+#include <memory>
+
+#include "resourcefetcher.hpp"
+
+namespace utility {
+
+/** ResourceFetcher serving resources from the local filesystem. Supported
+ *  locations:
+ *
+ *    file://path/to/file            plain file
+ *    zip://path/to/archive.zip#/inner/path   member of ZIP archive
+ *    tar://path/to/archive.tar#/inner/path   member of TAR archive
+ *
+ *  I.e. file:///abs/path is an absolute path. Paths are URL-decoded.
+ *
+ *  Queries are served in a thread pool. Members of one archive requested in
+ *  one MultiQuery are read by a single task. Opened archives are kept around
+ *  (and reopened when changed on disk).
+ *
+ *  Last modification time is taken from the file (or archive) itself.
+ *  Missing files are reported as HttpCode::NotFound, unsupported locations
+ *  as HttpCode::BadRequest.
+ */
+class LocalResourceFetcher : public ResourceFetcher {
+public:
+    struct Config {
+        /** Number of worker threads. Zero means ThreadPool::shared().
+         */
+        std::size_t threads;
+
+        /** Served resources expire maxAge seconds after fetch. Negative value
+         *  means no expiry information.
+         */
+        std::time_t maxAge;
+
+        /** Maximum number of archives kept open.
+         */
+        std::size_t openArchives;
+
+        Config() : threads(), maxAge(-1), openArchives(16) {}
+    };
+
+    LocalResourceFetcher(const Config &config = Config());
+
+    virtual ~LocalResourceFetcher();
+
+    struct Detail;
+
+private:
+    virtual void perform_impl(MultiQuery query, const Done &done) const;
+
+    std::shared_ptr<Detail> detail_;
+};
+
+} // namespace utility
+
+#endif // utility_localresourcefetcher_hpp_included_
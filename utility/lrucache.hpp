@@ -107,7 +107,10 @@ public:
 
     /** Return total cost of items in cache 
      */
-    cost_type totalCost() { return totalCost_; };
+    cost_type totalCost() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return totalCost_;
+    }
 
 private:
     typedef std::uint64_t priority_type;
@@ -33,31 +33,86 @@
 #ifndef utility_lrucache2_hpp_included_
 #define utility_lrucache2_hpp_included_
 
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <algorithm>
 #include <list>
+#include <memory>
 #include <unordered_map>
 #include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <thread>
+#include <vector>
 
 #include <boost/noncopyable.hpp>
 
 #include "dbglog/dbglog.hpp"
 
+#include "expected.hpp"
+#include "cachepolicy.hpp"
+#include "cachestats.hpp"
+#include "threadpool.hpp"
+
 namespace utility {
 
+namespace detail {
+
+/** Expiry time (third element) of loader's result, if present.
+ */
+template <typename T>
+typename std::enable_if<(std::tuple_size<T>::value > 2), std::time_t>::type
+loadedExpires(const T &result) { return std::get<2>(result); }
+
+template <typename T>
+typename std::enable_if<(std::tuple_size<T>::value < 3), std::time_t>::type
+loadedExpires(const T&) { return -1; }
+
+} // namespace detail
+
 /** Multi-threaded LRU cache implementation. Compared to the simpler LruCache
  *  class, this version has proper load locking and is suitable for items that
  *  are costly to load. Other threads may continue to use the cache while items
  *  are being loaded.
+ *
+ *  Eviction order is given by Policy (see cachepolicy.hpp), plain LRU by
+ *  default. Use WTinyLfuPolicy for workloads mixing bulk scans with
+ *  interactive access.
+ *
+ *  Items may have expiry time (absolute, in seconds, e.g. taken from
+ *  ResourceFetcher::Query::Body::expires). Expired items are removed
+ *  without any scanning (expiry times are kept in a min-heap). Within the
+ *  stale-while-revalidate window after expiry, an expired item is still
+ *  served and a refresh is started in the background of the request that
+ *  noticed it (see get() and getAsync()).
  */
-template<typename Key, typename Value, typename CostType = std::size_t>
+template<typename Key, typename Value, typename CostType = std::size_t
+         , template <typename, typename> class Policy = LruPolicy>
 class LruCache2 : boost::noncopyable
 {
 public:
     typedef std::shared_ptr<Value> value_pointer;
+    typedef Expected<value_pointer> expected_value;
+    typedef std::function<void(const expected_value&)> Callback;
+
+    /** Completion handler passed to asynchronous loader. Must be called
+     *  exactly once, either with loaded value, its cost and optional expiry
+     *  time or with an exception. Can be copied and called from any thread.
+     *
+     *  Value that must not be cached is passed via LoadDone::uncached(): it
+     *  is handed to the waiters registered so far and not stored (a stale
+     *  item being refreshed is dropped). Such load is not a failure.
+     */
+    class LoadDone;
 
     LruCache2(CostType maxCost)
-        : maxCost_(maxCost), totalCost_()
-        , missCnt_(0), hitCnt_(0)
-    {}
+        : maxCost_(maxCost), totalCost_(), usesExpiry_(false)
+        , staleWhileRevalidate_(), refreshQueue_(), refreshes_()
+    {
+        policy_.limit(maxCost);
+    }
 
     /** Get an item from the cache (identified by 'key'). If the item is not
      *  in the cache, the supplied loading function is called first. The loading
@@ -65,29 +120,113 @@ public:
      *  shared pointer to 'Value' and size is the cost of the item:
      *
      *    std::tuple<std::shared_ptr<Value>, CostType> loadFunc(Key);
+     *
+     *  The loading function may return expiry time as the third element
+     *  (std::time_t, -1 means never):
+     *
+     *    std::tuple<std::shared_ptr<Value>, CostType, std::time_t>
+     *        loadFunc(Key);
+     *
+     *  If the loading function throws, the entry is removed from the cache and
+     *  the exception is propagated (to asynchronous waiters as well).
+     *
+     *  When a stale item (inside the stale-while-revalidate window) is hit,
+     *  the stale value is returned and a refresh (a copy of loadFunc) is
+     *  posted to the refresh queue (see setRefreshQueue()); i.e. loadFunc
+     *  must be copyable and must not refer to anything that dies before the
+     *  refresh finishes. Failed refresh is only logged and the stale value
+     *  is served until its stale window ends. Destructor waits for
+     *  refreshes in progress.
+     *
+     *  Clock is read (outside of the cache lock) only once some item has had
+     *  an expiry time.
      */
     template<typename LoadFunc>
     value_pointer get(const Key &key, LoadFunc loadFunc);
 
+    /** Asynchronous version of get(). Never blocks on a load in progress.
+     *
+     *  If the item is in the cache, callback is called immediately (in the
+     *  calling thread). If the item is being loaded, callback is registered
+     *  and called when the load finishes. Otherwise, the loader is started:
+     *
+     *    void loader(const Key &key, LoadDone done);
+     *
+     *  The loader is expected to start the load (e.g. post it to an io
+     *  service) and return; once finished, it calls done(ptr, cost) or
+     *  done(std::exception_ptr). All registered callbacks are then called
+     *  from the thread calling done:
+     *
+     *    void callback(const Expected<std::shared_ptr<Value>> &value);
+     *
+     *  If the loader throws (without calling done) the load fails. Cache must
+     *  outlive all loads in progress.
+     *
+     *  A stale item is passed to the callback immediately and the loader is
+     *  started to refresh it.
+     */
+    template<typename AsyncLoadFunc>
+    void getAsync(const Key &key, AsyncLoadFunc loader
+                  , const Callback &callback);
+
     /** Set a limit on the total cost of items in the cache.
      */
-    void setMaxCost(CostType maxCost) { maxCost_ = maxCost; }
+    void setMaxCost(CostType maxCost) {
+        std::unique_lock<std::mutex> mainLock(mainMutex_);
+        maxCost_ = maxCost;
+        policy_.limit(maxCost);
+    }
 
-    /** Removes as many LRU elements as needed to get total cost under 'limit'.
-     *  Returns the number of items removed.
+    /** Set how long (in seconds) are expired items served while being
+     *  refreshed. Zero (default) means expired items are never served.
+     */
+    void setStaleWhileRevalidate(std::time_t seconds) {
+        std::unique_lock<std::mutex> mainLock(mainMutex_);
+        staleWhileRevalidate_ = seconds;
+    }
+
+    /** Set queue running stale refreshes started by get(). Defaults to
+     *  ThreadPool::shared(). The queue must outlive the cache.
+     */
+    void setRefreshQueue(const AsyncQueue &queue) {
+        std::unique_lock<std::mutex> mainLock(mainMutex_);
+        refreshQueue_ = &queue;
+    }
+
+    /** Removes expired items and then as many elements (as chosen by the
+     *  policy) as needed to get total cost under 'limit'. Returns the number
+     *  of items removed.
      */
     std::size_t trim(CostType limit) {
         std::unique_lock<std::mutex> mainLock(mainMutex_);
-        return trimImpl(limit);
+        return expireImpl(std::time(nullptr)) + trimImpl(limit);
     }
 
     /** Return total cost of items in the cache.
      */
-    CostType totalCost() { return totalCost_; }
+    CostType totalCost() {
+        std::unique_lock<std::mutex> mainLock(mainMutex_);
+        return totalCost_;
+    }
+
+    /** Returns snapshot of cache statistics.
+     */
+    CacheStats stats() {
+        CacheStats stats;
+        counters_.snapshot(stats);
+        std::unique_lock<std::mutex> mainLock(mainMutex_);
+        stats.items = policy_.size() + itemList_.size();
+        stats.cost = totalCost_;
+        return stats;
+    }
 
     ~LruCache2() {
-        LOG(info2) << "Cache hit count: " << hitCnt_
-                   << ", miss count: " << missCnt_;
+        // refreshes in progress refer to this cache
+        std::unique_lock<std::mutex> mainLock(mainMutex_);
+        refreshCond_.wait(mainLock, [this]() { return !refreshes_; });
+
+        LOG(info2) << "Cache hit count: " << counters_.hits()
+                   << ", miss count: " << counters_.misses();
     }
 
 protected:
@@ -98,114 +237,805 @@ protected:
         CostType cost;
 
         bool loading;
-        std::mutex loadMutex;
 
-        Item(const Key &key) : key(key), cost(), loading(true) {}
+        /** Expiry time, -1 = never.
+         */
+        std::time_t expires;
+
+        /** Stale item is being refreshed.
+         */
+        bool refreshing;
+
+        /** Policy specific tag.
+         */
+        unsigned char segment;
+
+        /** Asynchronous requests waiting for this item to load.
+         */
+        std::vector<Callback> waiters;
+
+        /** Signalled when this item's load finishes (successfully or not).
+         *  Created by the first blocked get(); shared since failed item is
+         *  destroyed while its waiters still use it.
+         */
+        std::shared_ptr<std::condition_variable> loadedCond;
+
+        detail::CacheCounters::Clock::time_point loadStart;
+
+        Item(const Key &key)
+            : key(key), cost(), loading(true), expires(-1), refreshing(false)
+            , segment()
+        {}
     };
 
+    /** Items being loaded. Loaded items are owned by the policy.
+     */
     std::list<Item> itemList_;
 
     typedef decltype(itemList_.begin()) list_iterator;
     std::unordered_map<Key, list_iterator> itemMap_;
 
+    Policy<Item, CostType> policy_;
+
     CostType maxCost_;
     CostType totalCost_;
-    long long missCnt_, hitCnt_;
+    detail::CacheCounters counters_;
+
+    /** Expiry heap entry. Entries are not removed with their items, they are
+     *  validated against the item when popped.
+     */
+    struct Expiry {
+        std::time_t expires;
+        Key key;
+
+        Expiry(std::time_t expires, const Key &key)
+            : expires(expires), key(key)
+        {}
+
+        /** Heap comparator (earliest on top).
+         */
+        static bool later(const Expiry &l, const Expiry &r) {
+            return l.expires > r.expires;
+        }
+    };
+
+    std::vector<Expiry> expiry_;
+
+    /** Set once any item has had expiry time; until then the clock is not
+     *  read at all.
+     */
+    std::atomic<bool> usesExpiry_;
+
+    std::time_t staleWhileRevalidate_;
+
+    /** Where get() runs stale refreshes, nullptr = ThreadPool::shared().
+     */
+    const AsyncQueue *refreshQueue_;
+
+    /** Number of refreshes posted by get() and not finished yet.
+     */
+    std::size_t refreshes_;
+    std::condition_variable refreshCond_;
 
     std::mutex mainMutex_;
 
     std::size_t trimImpl(CostType limit);
+
+    /** Removes items expired for more than stale-while-revalidate window.
+     */
+    std::size_t expireImpl(std::time_t now);
+
+    static bool expired(const Item &item, std::time_t now) {
+        return (item.expires >= 0) && (now >= item.expires);
+    }
+
+    /** Registers item's expiry time. Must be called under main lock.
+     */
+    void scheduleExpiry(const Item &item);
+
+    /** Creates new loading item. Must be called under main lock.
+     */
+    list_iterator startLoad(const Key &key);
+
+    /** Marks stale item as being refreshed. Must be called under main lock.
+     */
+    void startRefresh(Item &item);
+
+    /** Current time for expiry checks or -1 if no item has ever expired.
+     *  Call without main lock.
+     */
+    std::time_t expiryNow() const {
+        return (usesExpiry_.load(std::memory_order_relaxed)
+                ? std::time(nullptr) : -1);
+    }
+
+    /** Handles expiry under main lock; now is result of expiryNow().
+     *  Returns current time usable for expired().
+     */
+    std::time_t checkExpiry(std::time_t now);
+
+    /** Runs refresh of stale item (marked by startRefresh) in given queue
+     *  (nullptr = ThreadPool::shared()). Call without main lock.
+     */
+    template<typename LoadFunc>
+    void refreshAsync(const AsyncQueue *queue, const Key &key
+                      , const LoadFunc &loadFunc);
+
+    /** Finishes load of given item and notifies all waiters.
+     */
+    void loaded(list_iterator it, const value_pointer &ptr, CostType cost
+                , std::time_t expires);
+
+    /** Removes failed item and notifies all waiters.
+     */
+    void failed(list_iterator it, const std::exception_ptr &exc);
+
+    /** Removes item loaded with non-cacheable value and passes the value to
+     *  all waiters.
+     */
+    void uncached(list_iterator it, const value_pointer &ptr);
+
+    /** Replaces stale item with refreshed value (if still in the cache).
+     */
+    void refreshed(const Key &key, const value_pointer &ptr, CostType cost
+                   , std::time_t expires);
+
+    /** Stale item is kept until its stale window ends.
+     */
+    void refreshFailed(const Key &key, const std::exception_ptr &exc);
+
+    /** Refreshed value is not cacheable, stale item is dropped.
+     */
+    void refreshUncached(const Key &key);
+};
+
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+class LruCache2<Key, Value, CostType, Policy>::LoadDone {
+public:
+    void operator()(const value_pointer &ptr, CostType cost
+                    , std::time_t expires = -1) const
+    {
+        if (refresh_) {
+            cache_->refreshed(key_, ptr, cost, expires);
+        } else {
+            cache_->loaded(it_, ptr, cost, expires);
+        }
+    }
+
+    void operator()(const std::exception_ptr &exc) const {
+        if (refresh_) {
+            cache_->refreshFailed(key_, exc);
+        } else {
+            cache_->failed(it_, exc);
+        }
+    }
+
+    void uncached(const value_pointer &ptr) const {
+        if (refresh_) {
+            cache_->refreshUncached(key_);
+        } else {
+            cache_->uncached(it_, ptr);
+        }
+    }
+
+private:
+    friend class LruCache2;
+
+    LoadDone(LruCache2 *cache, list_iterator it, const Key &key
+             , bool refresh)
+        : cache_(cache), it_(it), key_(key), refresh_(refresh)
+    {}
+
+    LruCache2 *cache_;
+    list_iterator it_;
+    Key key_;
+    bool refresh_;
 };
 
 
 // implementation
 
-template<typename Key, typename Value, typename CostType>
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
 template<typename LoadFunc>
-typename LruCache2<Key, Value, CostType>::value_pointer
-LruCache2<Key, Value, CostType>::get(const Key &key, LoadFunc loadFunc)
+typename LruCache2<Key, Value, CostType, Policy>::value_pointer
+LruCache2<Key, Value, CostType, Policy>::get(const Key &key
+                                             , LoadFunc loadFunc)
 {
+    auto now(expiryNow());
     std::unique_lock<std::mutex> mainLock(mainMutex_);
+    policy_.record(key);
+    now = checkExpiry(now);
 
-    auto it = itemMap_.find(key);
-    if (it != itemMap_.end())
-    {
-        // item already in cache, move it to the end of the list
-        itemList_.splice(itemList_.end(), itemList_, it->second);
+    for (bool waiting(false);; waiting = true) {
+        auto it = itemMap_.find(key);
+        if (it == itemMap_.end()) { break; }
 
         Item &item = *(it->second);
         if (!item.loading)
         {
             LOG(info1) << "Cache hit on key <" << key << ">.";
-            hitCnt_++;
-            return item.ptr;
+            counters_.hit();
+            policy_.hit(it->second);
+            if (!expired(item, now)) { return item.ptr; }
+
+            counters_.stale();
+            if (item.refreshing) { return item.ptr; }
+
+            // stale item, serve it and refresh in the background
+            LOG(info1) << "Refreshing stale cache item <" << key
+                       << "> in background.";
+            const auto stale(item.ptr);
+            const auto queue(refreshQueue_);
+            startRefresh(item);
+            ++refreshes_;
+            mainLock.unlock();
+
+            refreshAsync(queue, key, loadFunc);
+            return stale;
         }
 
-        // the item is loading, wait and try again
+        // the item is loading, wait and try again (the item may be gone
+        // after failed load)
+        LOG(info1) << "Waiting while key <"  << key << "> is loading.";
+        if (!waiting) { counters_.wait(); }
+        if (!item.loadedCond) {
+            item.loadedCond = std::make_shared<std::condition_variable>();
+        }
+        const auto loadedCond(item.loadedCond);
+        loadedCond->wait(mainLock);
+    }
+
+    LOG(info1) << "Cache miss on key <" << key << ">.";
+    counters_.miss();
+
+    // create a new cache entry and unlock the cache
+    auto it(startLoad(key));
+    mainLock.unlock();
+
+    // load the item
+    LOG(info1) << "Loading cache item <" << key << ">.";
+    value_pointer ptr;
+    CostType cost;
+    std::time_t expires;
+    try {
+        const auto result(loadFunc(key));
+        ptr = std::get<0>(result);
+        cost = std::get<1>(result);
+        expires = detail::loadedExpires(result);
+    } catch (...) {
+        failed(it, std::current_exception());
+        throw;
+    }
+
+    loaded(it, ptr, cost, expires);
+    return ptr;
+}
+
+
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+template<typename AsyncLoadFunc>
+void LruCache2<Key, Value, CostType, Policy>
+::getAsync(const Key &key, AsyncLoadFunc loader, const Callback &callback)
+{
+    auto now(expiryNow());
+    std::unique_lock<std::mutex> mainLock(mainMutex_);
+    policy_.record(key);
+    now = checkExpiry(now);
+
+    auto fitem = itemMap_.find(key);
+    if (fitem != itemMap_.end())
+    {
+        Item &item = *(fitem->second);
+        if (item.loading) {
+            // the item is loading, just register and return
+            LOG(info1) << "Key <"  << key << "> is loading, registering.";
+            counters_.wait();
+            item.waiters.push_back(callback);
+            return;
+        }
+
+        LOG(info1) << "Cache hit on key <" << key << ">.";
+        counters_.hit();
+        policy_.hit(fitem->second);
+        const auto ptr(item.ptr);
+
+        if (!expired(item, now)) {
+            mainLock.unlock();
+            callback(ptr);
+            return;
+        }
+
+        counters_.stale();
+        if (item.refreshing) {
+            mainLock.unlock();
+            callback(ptr);
+            return;
+        }
+
+        // stale item: serve it and refresh
+        startRefresh(item);
+        const auto it(fitem->second);
         mainLock.unlock();
-        {
-            LOG(info1) << "Waiting while key <"  << key << "> is loading.";
-            std::lock_guard<std::mutex> loadLock(item.loadMutex);
+        callback(ptr);
+
+        LOG(info1) << "Refreshing stale cache item <" << key
+                   << "> asynchronously.";
+        try {
+            loader(key, LoadDone(this, it, key, true));
+        } catch (...) {
+            refreshFailed(key, std::current_exception());
         }
-        return get(key, loadFunc);
+        return;
     }
 
     LOG(info1) << "Cache miss on key <" << key << ">.";
-    missCnt_++;
+    counters_.miss();
+
+    auto it(startLoad(key));
+    it->waiters.push_back(callback);
+    mainLock.unlock();
+
+    LOG(info1) << "Loading cache item <" << key << "> asynchronously.";
+    try {
+        loader(key, LoadDone(this, it, key, false));
+    } catch (...) {
+        failed(it, std::current_exception());
+    }
+}
+
 
-    // create a new cache entry
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+typename LruCache2<Key, Value, CostType, Policy>::list_iterator
+LruCache2<Key, Value, CostType, Policy>::startLoad(const Key &key)
+{
     itemList_.emplace_back(key);
-    itemMap_[key] = --itemList_.end();
+    auto it(--itemList_.end());
+    itemMap_[key] = it;
+    it->loadStart = detail::CacheCounters::Clock::now();
+    return it;
+}
 
-    Item &item = itemList_.back();
-    item.loading = true;
 
-    // lock the item and unlock the cache
-    std::lock_guard<std::mutex> loadLock(item.loadMutex);
-    mainLock.unlock();
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+void LruCache2<Key, Value, CostType, Policy>::startRefresh(Item &item)
+{
+    item.refreshing = true;
+    item.loadStart = detail::CacheCounters::Clock::now();
+}
 
-    // load the item
-    LOG(info1) << "Loading cache item <" << key << ">.";
-    std::tie(item.ptr, item.cost) = loadFunc(key);
 
-    mainLock.lock();
-    totalCost_ += item.cost;
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+std::time_t LruCache2<Key, Value, CostType, Policy>
+::checkExpiry(std::time_t now)
+{
+    if (now < 0) {
+        // first item with expiry could have arrived since expiryNow()
+        if (!usesExpiry_.load(std::memory_order_relaxed)) { return now; }
+        now = std::time(nullptr);
+    }
+
+    // O(1) unless something is due
+    expireImpl(now);
+    return now;
+}
+
+
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+template<typename LoadFunc>
+void LruCache2<Key, Value, CostType, Policy>
+::refreshAsync(const AsyncQueue *queue, const Key &key
+               , const LoadFunc &loadFunc)
+{
+    const auto done([this]()
+    {
+        std::unique_lock<std::mutex> mainLock(mainMutex_);
+        if (!--refreshes_) { refreshCond_.notify_all(); }
+    });
+
+    const auto refresh([this, key, loadFunc, done]()
+    {
+        try {
+            const auto result(loadFunc(key));
+            refreshed(key, std::get<0>(result), std::get<1>(result)
+                      , detail::loadedExpires(result));
+        } catch (...) {
+            refreshFailed(key, std::current_exception());
+        }
+        done();
+    });
+
+    try {
+        if (queue) {
+            queue->post(refresh);
+        } else {
+            ThreadPool::shared().post(refresh);
+        }
+    } catch (...) {
+        refreshFailed(key, std::current_exception());
+        done();
+    }
+}
+
+
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+void LruCache2<Key, Value, CostType, Policy>
+::loaded(list_iterator it, const value_pointer &ptr, CostType cost
+         , std::time_t expires)
+{
+    std::vector<Callback> waiters;
+    std::shared_ptr<std::condition_variable> loadedCond;
+    {
+        std::unique_lock<std::mutex> mainLock(mainMutex_);
+        Item &item = *it;
+        item.ptr = ptr;
+        item.cost = cost;
+        item.expires = expires;
+        item.loading = false;
+        std::swap(waiters, item.waiters);
+        std::swap(loadedCond, item.loadedCond);
+        counters_.load(item.loadStart);
+        scheduleExpiry(item);
+
+        // hand the item over to the policy
+        totalCost_ += item.cost;
+        policy_.admit(itemList_, it);
+
+        // free items if necessary (may include this one)
+        trimImpl(maxCost_);
+    }
+    if (loadedCond) { loadedCond->notify_all(); }
+
+    for (const auto &waiter : waiters) { waiter(ptr); }
+}
+
+
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+void LruCache2<Key, Value, CostType, Policy>
+::failed(list_iterator it, const std::exception_ptr &exc)
+{
+    std::vector<Callback> waiters;
+    std::shared_ptr<std::condition_variable> loadedCond;
+    {
+        std::unique_lock<std::mutex> mainLock(mainMutex_);
+        LOG(info1) << "Failed to load cache item <" << it->key << ">.";
+        counters_.failure();
+        std::swap(waiters, it->waiters);
+        std::swap(loadedCond, it->loadedCond);
+        itemMap_.erase(it->key);
+        itemList_.erase(it);
+    }
+    if (loadedCond) { loadedCond->notify_all(); }
+
+    for (const auto &waiter : waiters) { waiter(exc); }
+}
+
+
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+void LruCache2<Key, Value, CostType, Policy>
+::uncached(list_iterator it, const value_pointer &ptr)
+{
+    std::vector<Callback> waiters;
+    std::shared_ptr<std::condition_variable> loadedCond;
+    {
+        std::unique_lock<std::mutex> mainLock(mainMutex_);
+        LOG(info1) << "Cache item <" << it->key << "> is not cacheable.";
+        counters_.load(it->loadStart);
+        std::swap(waiters, it->waiters);
+        std::swap(loadedCond, it->loadedCond);
+        itemMap_.erase(it->key);
+        itemList_.erase(it);
+    }
+    if (loadedCond) { loadedCond->notify_all(); }
+
+    for (const auto &waiter : waiters) { waiter(ptr); }
+}
+
+
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+void LruCache2<Key, Value, CostType, Policy>
+::refreshed(const Key &key, const value_pointer &ptr, CostType cost
+            , std::time_t expires)
+{
+    std::unique_lock<std::mutex> mainLock(mainMutex_);
+
+    auto fitem(itemMap_.find(key));
+    if ((fitem == itemMap_.end()) || !fitem->second->refreshing) {
+        // evicted in the meantime
+        LOG(info1) << "Refreshed cache item <" << key << "> is gone.";
+        return;
+    }
+
+    // take the item from the policy, update and re-admit (cost may change)
+    auto it(fitem->second);
+    policy_.release(itemList_, it);
+    totalCost_ -= it->cost;
+
+    it->ptr = ptr;
+    it->cost = cost;
+    it->expires = expires;
+    it->refreshing = false;
+    counters_.load(it->loadStart);
+    scheduleExpiry(*it);
+
+    totalCost_ += it->cost;
+    policy_.admit(itemList_, it);
 
-    // free LRU items if necessary
     trimImpl(maxCost_);
+}
+
+
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+void LruCache2<Key, Value, CostType, Policy>
+::refreshFailed(const Key &key, const std::exception_ptr &exc)
+{
+    std::unique_lock<std::mutex> mainLock(mainMutex_);
+    counters_.failure();
+
+    try {
+        std::rethrow_exception(exc);
+    } catch (const std::exception &e) {
+        LOG(warn2) << "Failed to refresh cache item <" << key
+                   << ">: " << e.what();
+    } catch (...) {
+        LOG(warn2) << "Failed to refresh cache item <" << key << ">.";
+    }
+
+    auto fitem(itemMap_.find(key));
+    if ((fitem == itemMap_.end()) || !fitem->second->refreshing) { return; }
+
+    // stale item lives until the end of its stale window
+    fitem->second->refreshing = false;
+    scheduleExpiry(*fitem->second);
+}
+
 
-    item.loading = false;
-    return item.ptr;
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+void LruCache2<Key, Value, CostType, Policy>::refreshUncached(const Key &key)
+{
+    std::unique_lock<std::mutex> mainLock(mainMutex_);
+
+    auto fitem(itemMap_.find(key));
+    if ((fitem == itemMap_.end()) || !fitem->second->refreshing) { return; }
+
+    LOG(info1) << "Refreshed cache item <" << key
+               << "> is not cacheable, dropping.";
+    auto it(fitem->second);
+    counters_.load(it->loadStart);
+    totalCost_ -= it->cost;
+    policy_.release(itemList_, it);
+    itemMap_.erase(fitem);
+    itemList_.erase(it);
 }
 
 
-template<typename Key, typename Value, typename CostType>
-std::size_t LruCache2<Key, Value, CostType>::trimImpl(CostType limit)
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+void LruCache2<Key, Value, CostType, Policy>
+::scheduleExpiry(const Item &item)
 {
-    std::size_t ndeleted = 0;
+    if (item.expires < 0) { return; }
+    usesExpiry_.store(true, std::memory_order_relaxed);
+
+    expiry_.emplace_back(item.expires, item.key);
+    std::push_heap(expiry_.begin(), expiry_.end(), &Expiry::later);
+
+    // entries of removed items are left in the heap; rebuild the heap when
+    // they prevail (amortized O(1))
+    if (expiry_.size() <= (2 * itemMap_.size() + 64)) { return; }
+
+    expiry_.clear();
+    for (const auto &entry : itemMap_) {
+        const auto &other(*entry.second);
+        if (other.loading || (other.expires < 0)) { continue; }
+        expiry_.emplace_back(other.expires, other.key);
+    }
+    std::make_heap(expiry_.begin(), expiry_.end(), &Expiry::later);
+}
+
 
-    auto it = itemList_.begin();
-    while (it != itemList_.end() && totalCost_ > limit)
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+std::size_t LruCache2<Key, Value, CostType, Policy>::expireImpl(std::time_t now)
+{
+    std::size_t nexpired(0);
+
+    while (!expiry_.empty()
+           && (now >= expiry_.front().expires + staleWhileRevalidate_))
     {
-        if (it->loading) {
-            it++;
+        std::pop_heap(expiry_.begin(), expiry_.end(), &Expiry::later);
+        const auto entry(expiry_.back());
+        expiry_.pop_back();
+
+        // validate entry
+        auto fitem(itemMap_.find(entry.key));
+        if (fitem == itemMap_.end()) { continue; }
+        auto it(fitem->second);
+        if (it->loading || it->refreshing || (it->expires != entry.expires)) {
             continue;
         }
 
-        LOG(info1) << "Deleting cache item <" << it->key << ">.";
+        LOG(info1) << "Expiring cache item <" << it->key << ">.";
         totalCost_ -= it->cost;
-        itemMap_.erase(it->key);
-        it = itemList_.erase(it);
-
-        ndeleted++;
+        counters_.expiration();
+        policy_.release(itemList_, it);
+        itemMap_.erase(fitem);
+        itemList_.erase(it);
+        ++nexpired;
     }
 
-    LOG(info1) << "Cache size is " << totalCost_ << " in " << itemList_.size()
+    return nexpired;
+}
+
+
+template<typename Key, typename Value, typename CostType
+         , template <typename, typename> class Policy>
+std::size_t LruCache2<Key, Value, CostType, Policy>::trimImpl(CostType limit)
+{
+    // items being loaded are not owned by the policy -> never deleted here
+    auto ndeleted(policy_.trim(totalCost_, limit, [&](const Item &item)
+    {
+        LOG(info1) << "Deleting cache item <" << item.key << ">.";
+        totalCost_ -= item.cost;
+        counters_.eviction(item.cost);
+        itemMap_.erase(item.key);
+    }));
+
+    LOG(info1) << "Cache size is " << totalCost_ << " in "
+               << (policy_.size() + itemList_.size())
                << " items (just deleted " << ndeleted << " items).";
 
     return ndeleted;
 }
 
+/** Sharded (lock-striped) version of LruCache2.
+ *
+ *  Keys are distributed (by hash) into a fixed number of independent
+ *  LruCache2 shards, each with its own lock and an equal share of the total
+ *  cost limit; total cost of all shards therefore never exceeds the global
+ *  limit. Threads accessing different shards never contend. Load-once
+ *  semantics of LruCache2 is kept since all accesses to given key go through
+ *  the same shard.
+ *
+ *  LRU order (or whatever order policy maintains) is per shard only.
+ *
+ *  NB: each shard is limited to its share (maxCost / shardCount()) of the
+ *  total limit; an item costing more than the per-shard share is never
+ *  retained (it is loaded and returned but immediately evicted). Pass
+ *  maxItemCost to the constructor to clamp the number of shards so that the
+ *  per-shard share stays at or above the largest expected item cost.
+ */
+template<typename Key, typename Value, typename CostType = std::size_t
+         , typename Hash = std::hash<Key>
+         , template <typename, typename> class Policy = LruPolicy>
+class ShardedLruCache2 : boost::noncopyable
+{
+public:
+    typedef LruCache2<Key, Value, CostType, Policy> Shard;
+    typedef typename Shard::value_pointer value_pointer;
+
+    /** Creates cache with given number of shards. Zero means number of
+     *  hardware threads (rounded up to power of two).
+     *
+     *  Non-zero maxItemCost halves the number of shards (down to a single
+     *  shard) until maxCost / shardCount() >= maxItemCost.
+     */
+    ShardedLruCache2(CostType maxCost, std::size_t shards = 0
+                     , CostType maxItemCost = 0)
+        : mask_(shardCount(shards, maxCost, maxItemCost) - 1)
+    {
+        const auto count(mask_ + 1);
+        shards_.reserve(count);
+        for (std::size_t i(0); i < count; ++i) {
+            shards_.emplace_back(new Shard(shareOf(maxCost)));
+        }
+    }
+
+    /** Same as LruCache2::get.
+     */
+    template<typename LoadFunc>
+    value_pointer get(const Key &key, LoadFunc loadFunc) {
+        return shard(key).get(key, loadFunc);
+    }
+
+    /** Same as LruCache2::setRefreshQueue.
+     */
+    void setRefreshQueue(const AsyncQueue &queue) {
+        for (auto &shard : shards_) { shard->setRefreshQueue(queue); }
+    }
+
+    /** Same as LruCache2::setStaleWhileRevalidate.
+     */
+    void setStaleWhileRevalidate(std::time_t seconds) {
+        for (auto &shard : shards_) {
+            shard->setStaleWhileRevalidate(seconds);
+        }
+    }
+
+    /** Same as LruCache2::getAsync.
+     */
+    template<typename AsyncLoadFunc>
+    void getAsync(const Key &key, AsyncLoadFunc loader
+                  , const typename Shard::Callback &callback)
+    {
+        shard(key).getAsync(key, loader, callback);
+    }
+
+    /** Set a limit on the total cost of items in the cache. Shard count is
+     *  fixed at construction: lowering the limit lowers the per-shard share
+     *  (and thus the maximum retained item cost) as well.
+     */
+    void setMaxCost(CostType maxCost) {
+        for (auto &shard : shards_) { shard->setMaxCost(shareOf(maxCost)); }
+    }
+
+    /** Removes as many LRU elements as needed to get total cost under 'limit'.
+     *  Each shard is trimmed to its share of the limit.
+     *  Returns the number of items removed.
+     */
+    std::size_t trim(CostType limit) {
+        std::size_t removed(0);
+        for (auto &shard : shards_) { removed += shard->trim(shareOf(limit)); }
+        return removed;
+    }
+
+    /** Return total cost of items in the cache.
+     */
+    CostType totalCost() {
+        CostType total(0);
+        for (auto &shard : shards_) { total += shard->totalCost(); }
+        return total;
+    }
+
+    /** Return statistics summed over all shards.
+     */
+    CacheStats stats() {
+        CacheStats stats;
+        for (auto &shard : shards_) { stats += shard->stats(); }
+        return stats;
+    }
+
+    std::size_t shardCount() const { return shards_.size(); }
+
+private:
+    static std::size_t shardCount(std::size_t shards, CostType maxCost
+                                  , CostType maxItemCost)
+    {
+        if (!shards) { shards = std::thread::hardware_concurrency(); }
+        std::size_t count(1);
+        while (count < shards) { count <<= 1; }
+        if (maxItemCost) {
+            while ((count > 1) && ((maxCost / count) < maxItemCost)) {
+                count >>= 1;
+            }
+        }
+        return count;
+    }
+
+    CostType shareOf(CostType cost) const { return cost / (mask_ + 1); }
+
+    Shard& shard(const Key &key) {
+        // mix hash bits (std::hash is identity for integers)
+        const std::uint64_t h(Hash()(key));
+        return *shards_[((h * 0x9e3779b97f4a7c15ull) >> 32) & mask_];
+    }
+
+    std::size_t mask_;
+    std::vector<std::unique_ptr<Shard> > shards_;
+};
+
 } // namespace utility
 
 #endif // utility_lrucache2_hpp_included_
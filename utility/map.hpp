@@ -29,16 +29,58 @@
 #include <future>
 #include <cstdlib>
 #include <utility>
+#include <memory>
 
 #include <boost/thread.hpp>
 #include <boost/range.hpp>
 
 #include "dbglog/dbglog.hpp"
 
+#include "threadpool.hpp"
 #include "detail/map.hpp"
 
 namespace utility {
 
+/** Parallel map configuration.
+ */
+struct MapOptions {
+    enum class Schedule {
+        /** Sequence is split into one contiguous range per thread, each range
+         *  is processed by its own (new) thread.
+         */
+        partition
+
+        /** Small chunks are taken dynamically by threads of the shared
+         *  thread pool (and the calling thread) until there is nothing left.
+         *  Suitable for items with uneven processing cost.
+         */
+        , dynamic
+    };
+
+    Schedule schedule;
+
+    /** Number of threads, zero means number of hardware threads (or one if
+     *  NO_THREADS environment variable is set).
+     */
+    std::size_t threads;
+
+    /** Number of items in one chunk (dynamic schedule only), zero means
+     *  automatic size.
+     */
+    std::size_t chunk;
+
+    /** Maximum number of items in flight (streamMap only), i.e. items taken
+     *  from the input but not yet passed to the sink. Zero means 4 times the
+     *  number of threads.
+     */
+    std::size_t window;
+
+    MapOptions(Schedule schedule = Schedule::partition
+               , std::size_t threads = 0, std::size_t chunk = 0)
+        : schedule(schedule), threads(threads), chunk(chunk), window()
+    {}
+};
+
 /** Returns [ callable(value, args...) for value in values ], i.e. vector of
  * values mapped by `callable'.
  *
@@ -59,17 +101,74 @@ namespace utility {
  * \return list of results
  */
 template <typename Sequence, typename Callable, typename... Args>
-typename detail::map_helper<Sequence, Callable, Args...>::ResultList
+typename detail::map_result<Sequence, Callable, Args...>::type
 map(const std::string &name, const Sequence &values
     , const Callable &callable, Args&& ...args);
 
+/** Same as map above with explicit scheduling configuration.
+ */
+template <typename Sequence, typename Callable, typename... Args>
+typename detail::map_helper<Sequence, Callable, Args...>::ResultList
+map(const std::string &name, const MapOptions &options
+    , const Sequence &values, const Callable &callable, Args&& ...args);
+
+/** Streaming version of map with bounded memory.
+ *
+ * Values are pulled one by one from generator (called from one thread at a
+ * time) until it returns none:
+ *
+ *     boost::optional<Value> generator();
+ *
+ * and processed in parallel by callable(value, args...) (by threads of the
+ * shared thread pool and the calling thread). Results are passed to the sink
+ * (called from one thread at a time) in input order:
+ *
+ *     void sink(Result &result);
+ *
+ * where Result is the same as map's ResultList value_type. At most
+ * options.window items are in flight at any time; memory use therefore
+ * does not depend on input size. Schedule and chunk options are ignored.
+ *
+ * Exception thrown by the generator or by the sink stops processing and is
+ * rethrown (after all in-flight items are finished).
+ *
+ * \param name name of operation (used in log messages)
+ * \param options thread count and window size
+ * \param generator value source
+ * \param callable callable(const Value&, args...)
+ * \param sink result sink
+ * \param ...args arguments to be passed to each call of callable
+ */
+template <typename Generator, typename Callable, typename Sink
+          , typename... Args>
+void streamMap(const std::string &name, const MapOptions &options
+               , Generator generator, const Callable &callable
+               , const Sink &sink, Args&& ...args);
+
+/** Generator over [begin, end) range, for use with streamMap.
+ */
+template <typename Iterator>
+detail::RangeGenerator<Iterator> rangeGenerator(Iterator begin, Iterator end)
+{
+    return detail::RangeGenerator<Iterator>(begin, end);
+}
+
 // ************************************************************************
 // Implementation
 
 template <typename Sequence, typename Callable, typename... Args>
-typename detail::map_helper<Sequence, Callable, Args...>::ResultList
+typename detail::map_result<Sequence, Callable, Args...>::type
 map(const std::string &name, const Sequence &values
     , const Callable &callable, Args&& ...args)
+{
+    return map(name, MapOptions(), values, callable
+               , std::forward<Args>(args)...);
+}
+
+template <typename Sequence, typename Callable, typename... Args>
+typename detail::map_helper<Sequence, Callable, Args...>::ResultList
+map(const std::string &name, const MapOptions &options
+    , const Sequence &values, const Callable &callable, Args&& ...args)
 {
     typedef detail::map_helper<Sequence, Callable, Args&&...> Helper;
     typedef typename Helper::ResultList ResultList;
@@ -77,15 +176,10 @@ map(const std::string &name, const Sequence &values
 
     Helper helper;
 
-    // NB: std::thread::hardware_concurrency() returned 0 at the time when this
-    // was written, using boost::thread::hardware_concurrency() instead
     size_t threadCount
         (std::min<size_t>
-         (boost::thread::hardware_concurrency(), values.size()));
-
-    if (getenv("NO_THREADS")) {
-        threadCount = 1;
-    }
+         (options.threads ? options.threads : detail::mapThreads()
+          , values.size()));
 
     if (threadCount < 2) {
         // single thread -> just run here
@@ -97,14 +191,52 @@ map(const std::string &name, const Sequence &values
         return result;
     }
 
-    std::vector<std::future<void> > jobs;
-    jobs.reserve(values.size());
-
     ResultList result;
     result.resize(values.size());
 
     size_t count(values.size());
 
+    if (options.schedule == MapOptions::Schedule::dynamic) {
+        auto call([&](const typename Helper::value_type &value)
+        {
+            return callable(value, args...);
+        });
+
+        typedef detail::DynamicMap<Sequence, ResultList, decltype(call)>
+            DynamicMap;
+
+        // keep chunks small enough to balance the load
+        auto chunk(options.chunk);
+        if (!chunk) {
+            chunk = std::max<std::size_t>
+                (1, std::min<std::size_t>(256, count / (threadCount * 32)));
+        }
+
+        // state is shared with the helpers: some may start after we are
+        // done
+        auto state(std::make_shared<DynamicMap>
+                   (name, values, result, call, count, chunk));
+
+        // start thread logging
+        dbglog::log_thread();
+
+        // calling thread works as well -> nested maps cannot deadlock
+        auto &pool(ThreadPool::shared());
+        for (size_t i(1); i < threadCount; ++i) {
+            pool.post([state]() { state->work(); });
+        }
+        state->work();
+        state->wait();
+
+        // stop thread logging
+        dbglog::log_thread(false);
+
+        return result;
+    }
+
+    std::vector<std::future<void> > jobs;
+    jobs.reserve(values.size());
+
     // compute partition size
     size_t partition(count / threadCount);
     int extra(count % threadCount);
@@ -142,6 +274,49 @@ map(const std::string &name, const Sequence &values
     return result;
 }
 
+template <typename Generator, typename Callable, typename Sink
+          , typename... Args>
+void streamMap(const std::string &name, const MapOptions &options
+               , Generator generator, const Callable &callable
+               , const Sink &sink, Args&& ...args)
+{
+    auto call([&](const typename detail::GeneratorValue<Generator>::type
+                  &value)
+    {
+        return callable(value, args...);
+    });
+
+    typedef detail::StreamMap<Generator, decltype(call), Sink> StreamMap;
+
+    const auto threadCount
+        (std::max<std::size_t>
+         (1, options.threads ? options.threads : detail::mapThreads()));
+    const auto window(options.window ? options.window : 4 * threadCount);
+
+    // state is shared with the helpers: some may start after we are done
+    auto state(std::make_shared<StreamMap>
+               (name, generator, call, sink, window));
+
+    // start thread logging
+    dbglog::log_thread();
+
+    auto &pool(ThreadPool::shared());
+    for (size_t i(1); i < threadCount; ++i) {
+        pool.post([state]() { state->work(); });
+    }
+    state->work();
+
+    try {
+        state->wait();
+    } catch (...) {
+        dbglog::log_thread(false);
+        throw;
+    }
+
+    // stop thread logging
+    dbglog::log_thread(false);
+}
+
 } // namespace utility
 
 #endif // shared_utility_map_hpp_included_
@@ -36,7 +36,14 @@ struct MemInfo {
         std::size_t free;
         std::size_t buffers;
 
-        std::size_t available() const { return free + buffers; }
+        /** Kernel's estimate of memory available for new allocations
+         *  (MemAvailable in /proc/meminfo). Zero when unknown.
+         */
+        std::size_t estimated;
+
+        std::size_t available() const {
+            return estimated ? estimated : free + buffers;
+        }
     };
     Mem ram;
     Mem swap;
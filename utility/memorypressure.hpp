@@ -0,0 +1,205 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file utility/memorypressure.hpp
+ *
+ * Memory pressure monitoring.
+ */
+
+#ifndef utility_memorypressure_hpp_included_
+#define utility_memorypressure_hpp_included_
+
+#include <cstddef>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include "meminfo.hpp"
+
+namespace utility {
+
+/** Snapshot of memory state.
+ */
+struct MemoryPressure {
+    enum class Level { none, moderate, critical };
+
+    Level level;
+
+    /** System memory information.
+     */
+    MemInfo meminfo;
+
+    /** cgroup v2 memory limit (memory.max) and usage (memory.current) of this
+     *  process' cgroup. Zero limit means no limit.
+     */
+    std::size_t cgroupLimit;
+    std::size_t cgroupUsage;
+
+    /** Pressure stall information: share of time (percent, last 10 seconds)
+     *  in which some/all tasks were stalled on memory. Negative if PSI is not
+     *  available.
+     */
+    double someAvg10;
+    double fullAvg10;
+
+    /** Set when woken up by PSI trigger.
+     */
+    bool triggered;
+
+    MemoryPressure()
+        : level(Level::none), meminfo(), cgroupLimit(), cgroupUsage()
+        , someAvg10(-1.0), fullAvg10(-1.0), triggered(false)
+    {}
+
+    /** Memory limit: cgroup limit if set, total RAM otherwise.
+     */
+    std::size_t limit() const;
+
+    /** Memory available to this process (respects cgroup limit).
+     */
+    std::size_t available() const;
+
+    /** Reads current memory state. Level is not computed.
+     */
+    static MemoryPressure read();
+};
+
+/** Background monitor of memory pressure.
+ *
+ *  Watches available memory (MemAvailable, cgroup v2 memory.max and
+ *  memory.current) and pressure stall information (PSI, cgroup's
+ *  memory.pressure or /proc/pressure/memory). A PSI trigger is registered and
+ *  waited for by poll(), i.e. pressure is reported promptly; memory levels
+ *  are checked every interval.
+ *
+ *  When pressure level rises (none -> moderate -> critical) all subscribers
+ *  are called (from the monitor thread) and then, if asked to, malloc_trim
+ *  is called to return freed memory to the system. While the pressure lasts
+ *  without rising, subscribers are called again at most once per
+ *  Config::repeat; i.e. a cache trimmed on pressure gets time to settle
+ *  instead of being trimmed on every check.
+ *
+ *  Available on Linux only, constructor throws elsewhere.
+ */
+class MemoryPressureMonitor {
+public:
+    struct Config {
+        /** Check interval.
+         */
+        std::chrono::milliseconds interval;
+
+        /** Level is moderate when available memory drops below this share of
+         *  limit.
+         */
+        double moderate;
+
+        /** Level is critical when available memory drops below this share of
+         *  limit.
+         */
+        double critical;
+
+        /** PSI trigger: report pressure when some tasks are stalled for
+         *  psiStall during psiWindow. Unprivileged processes need window to
+         *  be a multiple of 2 seconds.
+         */
+        std::chrono::microseconds psiStall;
+        std::chrono::microseconds psiWindow;
+
+        /** Call malloc_trim after notifying subscribers.
+         */
+        bool mallocTrim;
+
+        /** Minimum time between notifications while pressure level does not
+         *  rise. Zero means notify on every check under pressure.
+         */
+        std::chrono::milliseconds repeat;
+
+        Config()
+            : interval(1000), moderate(.1), critical(.05)
+            , psiStall(200000), psiWindow(2000000), mallocTrim(true)
+            , repeat(10000)
+        {}
+    };
+
+    typedef std::function<void(const MemoryPressure&)> Callback;
+    typedef std::size_t Subscription;
+
+    MemoryPressureMonitor(const Config &config = Config());
+
+    /** Stops monitoring thread.
+     */
+    ~MemoryPressureMonitor();
+
+    /** Registers callback. Returns subscription to be used to unsubscribe.
+     */
+    Subscription subscribe(const Callback &callback);
+
+    /** Unregisters callback. Waits for running notification, i.e. callback
+     *  is not called after return. Must not be called from a callback.
+     */
+    void unsubscribe(Subscription subscription);
+
+    /** Subscribes cache trimming: cache is trimmed to given share of its
+     *  current total cost on moderate/critical pressure notification (i.e.
+     *  critical share of 0 empties the cache). Notifications are rate
+     *  limited (see Config::repeat), cache is not trimmed on every check.
+     *  Works with any cache providing thread safe totalCost() and
+     *  trim(limit) (LruCache, LruCache2, ShardedLruCache2, ClockCache).
+     *  Cache must outlive subscription.
+     */
+    template <typename Cache>
+    Subscription trimOnPressure(Cache &cache, double moderate = .5
+                                , double critical = .25);
+
+    /** Last observed state.
+     */
+    MemoryPressure current() const;
+
+    struct Detail;
+
+private:
+    std::unique_ptr<Detail> detail_;
+};
+
+// inlines
+
+template <typename Cache>
+MemoryPressureMonitor::Subscription
+MemoryPressureMonitor::trimOnPressure(Cache &cache, double moderate
+                                      , double critical)
+{
+    return subscribe([&cache, moderate, critical]
+                     (const MemoryPressure &pressure)
+    {
+        const auto share((pressure.level == MemoryPressure::Level::critical)
+                         ? critical : moderate);
+        cache.trim(decltype(cache.totalCost())(cache.totalCost() * share));
+    });
+}
+
+} // namespace utility
+
+#endif // utility_memorypressure_hpp_included_
@@ -0,0 +1,180 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file utility/procsampler.hpp
+ *
+ * Lightweight periodic process statistics sampler.
+ */
+
+#ifndef utility_procsampler_hpp_included_
+#define utility_procsampler_hpp_included_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+#include "procstat.hpp"
+
+namespace utility {
+
+/** Persistent sampler of process statistics that does not need libproc.
+ *
+ *  Keeps /proc/<pid>/stat and /proc/<pid>/statm open and re-reads them by
+ *  pread into stack buffers, i.e. sampling does not allocate as long as the
+ *  set of sampled processes does not change. Designed for being polled
+ *  periodically (e.g. every second).
+ *
+ *  If asked to, whole process trees are sampled: descendants of root
+ *  processes are discovered on each sample via
+ *  /proc/<pid>/task/<pid>/children (i.e. children forked by the main thread
+ *  of each process).
+ *
+ *  ProcStat::swap is filled in only if asked to (needs parsing of
+ *  /proc/<pid>/status).
+ *
+ *  Not thread safe. Available on Linux only, constructor throws elsewhere.
+ */
+class ProcSampler {
+public:
+    struct Config {
+        /** Sample descendants of given processes as well.
+         */
+        bool tree;
+
+        /** Read swap usage.
+         */
+        bool swap;
+
+        Config() : tree(false), swap(false) {}
+    };
+
+    struct Sample {
+        ProcStat stat;
+
+        /** CPU usage (user + system, without reaped children) since previous
+         *  sample in percent of one CPU (i.e. can exceed 100% for
+         *  multithreaded processes). Negative in first sample of given
+         *  process.
+         */
+        double cpu;
+
+        typedef std::vector<Sample> list;
+    };
+
+    /** Samples given processes. Empty list means this process.
+     */
+    ProcSampler(const PidList &pids = PidList(), const Config &config
+                = Config());
+
+    ~ProcSampler();
+
+    /** Samples all processes. Vanished processes are silently dropped (root
+     *  processes included). Returned reference is valid until next call.
+     */
+    const Sample::list& sample();
+
+    /** Sum of last samples (cpu usage of processes with no previous sample
+     *  is ignored). Pid is pid of first root process.
+     */
+    Sample total() const;
+
+    struct Detail;
+
+private:
+    std::unique_ptr<Detail> detail_;
+};
+
+/** Statistics of single thread.
+ */
+struct ThreadStat {
+    /** Thread ID.
+     */
+    ProcStat::Pid tid;
+
+    /** Thread name (see utility::thread::setName).
+     */
+    std::string name;
+
+    /** This thread's utime [clock ticks]
+     */
+    std::size_t utime;
+
+    /** This thread's stime [clock ticks]
+     */
+    std::size_t stime;
+
+    /** Number of voluntary context switches (i.e. blocking).
+     */
+    std::size_t voluntarySwitches;
+
+    /** Number of involuntary context switches (i.e. preemption).
+     */
+    std::size_t involuntarySwitches;
+
+    /** CPU usage since previous sample in percent of one CPU. Negative in
+     *  first sample of given thread.
+     */
+    double cpu;
+
+    typedef std::vector<ThreadStat> list;
+};
+
+/** Persistent sampler of per-thread statistics of one process.
+ *
+ *  Threads are enumerated from /proc/<pid>/task on each sample; per-thread
+ *  stat and status files are kept open and re-read by pread.
+ *
+ *  Not thread safe. Available on Linux only, constructor throws elsewhere.
+ */
+class ThreadSampler {
+public:
+    /** Samples threads of given process. Zero means this process.
+     */
+    ThreadSampler(ProcStat::Pid pid = 0);
+
+    ~ThreadSampler();
+
+    /** Samples all threads. Returned reference is valid until next call.
+     */
+    const ThreadStat::list& sample();
+
+    /** Reports threads from last sample sorted by CPU usage (highest first)
+     *  to output stream, one "name.<thread name>.<tid>.cpu=value" line per
+     *  thread. At most top threads are reported (zero means all).
+     */
+    void report(std::ostream &os, const std::string &name
+                , std::size_t top = 0) const;
+
+    struct Detail;
+
+private:
+    std::unique_ptr<Detail> detail_;
+};
+
+} // namespace utility
+
+#endif // utility_procsampler_hpp_included_
@@ -37,7 +37,7 @@
 
 namespace utility {
 
-std::size_t ProcStat::ClocksPerSecond(::sysconf(_SC_CLK_TCK));
+// ProcStat::ClocksPerSecond is defined in detail/procsampler.linux.cpp
 
 namespace {
 std::size_t pageSize(::sysconf(_SC_PAGESIZE));
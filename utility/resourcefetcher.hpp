@@ -38,6 +38,7 @@
 #include "uri.hpp"
 #include "supplement.hpp"
 #include "errorcode.hpp"
+#include "sharedbuffer.hpp"
 
 namespace utility {
 
@@ -57,7 +58,13 @@ public:
             std::time_t expires;
             std::error_code redirect;
             std::string contentType;
-            std::string data;
+
+            /** Shared immutable payload; copies of body share memory.
+             *
+             *  NB: was std::string. Use data() / size() or str() (copy);
+             *  the content is not null-terminated.
+             */
+            SharedBuffer data;
 
             Body() : lastModified(-1), expires(-1), redirect() {}
         };
@@ -110,16 +117,34 @@ public:
 
         const Options& options() const { return options_; }
 
+        /** Sets body, copies data.
+         */
         void set(std::time_t lastModified, std::time_t expires
                  , const void *data, std::size_t size
                  , const std::string &contentType);
 
+        /** Sets body, shares (or adopts) data without copying. Use
+         *  SharedBuffer(std::move(string)) to hand over owned memory.
+         */
+        void set(std::time_t lastModified, std::time_t expires
+                 , SharedBuffer data, const std::string &contentType);
+
         void redirect(const std::string &url, std::error_code code);
 
         void error(std::exception_ptr exc) { exc_ = std::move(exc); }
 
         void error(std::error_code ec) {ec_ = std::move(ec); }
 
+        /** Copies result (body, exception and error code) from other query.
+         *  Location, options and supplement are kept intact.
+         */
+        Query& copyResult(const Query &other) {
+            body_ = other.body_;
+            exc_ = other.exc_;
+            ec_ = other.ec_;
+            return *this;
+        }
+
         const Body& get() const;
 
         Body&& moveOut();
@@ -269,11 +294,19 @@ inline void ResourceFetcher::Query::set(std::time_t lastModified
                                         , std::time_t expires
                                         , const void *data, std::size_t size
                                         , const std::string &contentType)
+{
+    set(lastModified, expires, SharedBuffer(data, size), contentType);
+}
+
+inline void ResourceFetcher::Query::set(std::time_t lastModified
+                                        , std::time_t expires
+                                        , SharedBuffer data
+                                        , const std::string &contentType)
 {
     body_.lastModified = lastModified;
     body_.expires = expires;
     body_.contentType = contentType;
-    body_.data.assign(static_cast<const char*>(data), size);
+    body_.data = std::move(data);
     body_.redirect = std::error_code();
     exc_ = {};
     ec_ = {};
@@ -283,7 +316,7 @@ inline void ResourceFetcher::Query::redirect(const std::string &url
                                              , std::error_code code)
 {
     body_.lastModified = body_.expires = -1;
-    body_.data = url;
+    body_.data = SharedBuffer(std::string(url));
     body_.contentType.clear();
     body_.redirect = code;
     exc_ = {};
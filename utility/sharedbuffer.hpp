@@ -0,0 +1,181 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file utility/sharedbuffer.hpp
+ *
+ * Immutable, reference counted memory buffer.
+ */
+
+#ifndef utility_sharedbuffer_hpp_included_
+#define utility_sharedbuffer_hpp_included_
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace utility {
+
+/** Immutable view of memory kept alive by a shared owner. Copies share the
+ *  same memory.
+ *
+ *  Memory can be adopted from std::string or std::vector<char> (moved, not
+ *  copied) or any owner, e.g. a memory mapping:
+ *
+ *      SharedBuffer(mapping, mapping->data(), mapping->size())
+ */
+class SharedBuffer {
+public:
+    SharedBuffer() : data_(), size_() {}
+
+    /** Adopts string content.
+     */
+    explicit SharedBuffer(std::string &&data);
+
+    /** Adopts vector content.
+     */
+    explicit SharedBuffer(std::vector<char> &&data);
+
+    /** Copies given memory.
+     */
+    SharedBuffer(const void *data, std::size_t size);
+
+    /** Memory [data, data + size) owned (kept alive) by owner.
+     */
+    SharedBuffer(std::shared_ptr<const void> owner, const char *data
+                 , std::size_t size)
+        : owner_(std::move(owner)), data_(data), size_(size)
+    {}
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return !size_; }
+
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + size_; }
+
+    /** Copy of the content.
+     */
+    std::string str() const { return std::string(data_, size_); }
+
+    /** Copy of the content, for code written against plain std::string
+     *  data. Explicit since it copies the whole buffer.
+     */
+    explicit operator std::string() const { return str(); }
+
+    /** Number of holders of the memory.
+     */
+    long useCount() const { return owner_.use_count(); }
+
+private:
+    template <typename Container>
+    static std::shared_ptr<Container> adopt(Container &&data) {
+        return std::make_shared<Container>(std::move(data));
+    }
+
+    std::shared_ptr<const void> owner_;
+    const char *data_;
+    std::size_t size_;
+};
+
+bool operator==(const SharedBuffer &l, const SharedBuffer &r);
+bool operator==(const SharedBuffer &l, const std::string &r);
+bool operator==(const std::string &l, const SharedBuffer &r);
+bool operator==(const SharedBuffer &l, const char *r);
+bool operator==(const char *l, const SharedBuffer &r);
+
+template <typename T>
+bool operator!=(const SharedBuffer &l, const T &r) { return !(l == r); }
+
+template<typename CharT, typename Traits>
+std::basic_ostream<CharT, Traits>&
+operator<<(std::basic_ostream<CharT, Traits> &os, const SharedBuffer &b);
+
+// inlines
+
+inline SharedBuffer::SharedBuffer(std::string &&data)
+    : data_(), size_()
+{
+    auto owner(adopt(std::move(data)));
+    data_ = owner->data();
+    size_ = owner->size();
+    owner_ = std::move(owner);
+}
+
+inline SharedBuffer::SharedBuffer(std::vector<char> &&data)
+    : data_(), size_()
+{
+    auto owner(adopt(std::move(data)));
+    data_ = owner->data();
+    size_ = owner->size();
+    owner_ = std::move(owner);
+}
+
+inline SharedBuffer::SharedBuffer(const void *data, std::size_t size)
+    : SharedBuffer(std::string(static_cast<const char*>(data), size))
+{}
+
+inline bool operator==(const SharedBuffer &l, const SharedBuffer &r)
+{
+    return ((l.size() == r.size())
+            && (l.empty() || (l.data() == r.data())
+                || !std::memcmp(l.data(), r.data(), l.size())));
+}
+
+inline bool operator==(const SharedBuffer &l, const std::string &r)
+{
+    return ((l.size() == r.size())
+            && (l.empty() || !std::memcmp(l.data(), r.data(), l.size())));
+}
+
+inline bool operator==(const std::string &l, const SharedBuffer &r)
+{
+    return r == l;
+}
+
+inline bool operator==(const SharedBuffer &l, const char *r)
+{
+    const auto size(std::strlen(r));
+    return ((l.size() == size)
+            && (!size || !std::memcmp(l.data(), r, size)));
+}
+
+inline bool operator==(const char *l, const SharedBuffer &r)
+{
+    return r == l;
+}
+
+template<typename CharT, typename Traits>
+inline std::basic_ostream<CharT, Traits>&
+operator<<(std::basic_ostream<CharT, Traits> &os, const SharedBuffer &b)
+{
+    return os.write(b.data(), b.size());
+}
+
+} // namespace utility
+
+#endif // utility_sharedbuffer_hpp_included_
@@ -25,9 +25,17 @@
  */
 #include <sys/stat.h>
 #include <fcntl.h>
+#ifdef __linux__
+#  include <sys/sendfile.h>
+#endif
 
+#include <algorithm>
+#include <cstring>
+#include <istream>
 #include <system_error>
 
+#include <boost/optional.hpp>
+
 #include "utility/unistd_compat.hpp"
 #include "dbglog/dbglog.hpp"
 
@@ -71,6 +79,38 @@ std::string getString(const char *v)
     return { v };
 }
 
+/** Parses path and size from PAX extended header records.
+ */
+void parsePax(const Data &data, boost::optional<std::string> &path
+              , boost::optional<std::size_t> &size)
+{
+    const auto *p(data.data());
+    const auto *e(p + data.size());
+
+    while (p < e) {
+        // record: "length key=value\n"
+        char *end(nullptr);
+        const auto length(std::strtoul(p, &end, 10));
+        if (!length || (end == p) || (length > std::size_t(e - p))) {
+            break;
+        }
+
+        const std::string record(static_cast<const char*>(end) + 1
+                                 , p + length - 1);
+        p += length;
+
+        const auto eq(record.find('='));
+        if (eq == std::string::npos) { continue; }
+
+        const auto key(record.substr(0, eq));
+        if (key == "path") {
+            path = record.substr(eq + 1);
+        } else if (key == "size") {
+            size = std::strtoull(record.c_str() + eq + 1, nullptr, 10);
+        }
+    }
+}
+
 } // namespace
 
 Type Header::type() const
@@ -215,43 +255,324 @@ Reader::File::list Reader::files(std::size_t limit)
 
     File::list files;
 
+    // overrides from PAX extended header or GNU long name
+    boost::optional<std::string> longPath;
+    auto longSize(boost::make_optional(false, std::size_t()));
+
     for (Header header; read(header); ) {
         if (!header.valid()) {
             continue;
         }
 
+        switch (*header.typeflag()) {
+        case 'x': case 'L': {
+            const auto start(cursor());
+            const auto data(readData(start, header.getSize()));
+            if (*header.typeflag() == 'x') {
+                parsePax(data, longPath, longSize);
+            } else {
+                longPath = std::string
+                    (data.begin(), std::find(data.begin(), data.end()
+                                             , '\0'));
+            }
+            seek(start + header.getBlocks());
+            continue;
+        }
+
+        default: break;
+        }
+
+        const auto size(longSize ? *longSize : header.getSize());
+
         if (header.isFile()) {
             std::size_t start(cursorByte());
-            files.emplace_back(header.getPath()
-                               , start, header.getSize());
+            files.emplace_back(longPath ? fs::path(*longPath)
+                               : header.getPath()
+                               , start, size);
 
             // apply limit
             if (files.size() >= limit) { break; }
         }
 
         // skip file/whatever content
-        skip(header);
+        advance((size + 511UL) / 512UL);
+        longPath = boost::none;
+        longSize = boost::none;
     }
 
     return files;
 }
 
-#if 0
-// TODO: implement me
+namespace {
+
+/** Size of read buffer used when scanning headers.
+ */
+constexpr std::size_t ScanBufferSize = 1 << 16;
+
+/** Reads up to size bytes at given offset. Returns less only at EOF.
+ */
+std::size_t preadAll(const utility::Filedes &fd, char *data, std::size_t size
+                     , std::size_t offset)
+{
+    std::size_t total(0);
+    while (total < size) {
+        auto bytes(TEMP_FAILURE_RETRY
+                   (::pread(fd, data + total, size - total
+                            , offset + total)));
+        if (bytes == -1) {
+            std::system_error e(errno, std::system_category());
+            LOG(err2) << "Cannot read from tar file " << fd.path() << ": <"
+                      << e.code() << ", " << e.what() << ">.";
+            throw e;
+        }
+
+        if (!bytes) { break; }
+        total += bytes;
+    }
+    return total;
+}
+
+} // namespace
+
+IndexedReader::IndexedReader(const fs::path &path, std::size_t limit)
+    : path_(path), fd_(::open(path.string().c_str(), O_RDONLY), path)
+{
+    if (!fd_) {
+        std::system_error e(errno, std::system_category());
+        LOG(err2) << "Cannot open tar file " << fd_.path() << ": <"
+                  << e.code() << ", " << e.what() << ">.";
+        throw e;
+    }
+
+    // buffered window into the file: [bufferStart, bufferStart + bufferSize)
+    std::vector<char> buffer(ScanBufferSize);
+    std::size_t bufferStart(0);
+    std::size_t bufferSize(0);
+
+    // returns pointer to header at given offset or nullptr at EOF
+    const auto header([&](std::size_t offset) -> const Header*
+    {
+        if ((offset < bufferStart)
+            || ((offset + sizeof(Block)) > (bufferStart + bufferSize)))
+        {
+            // outside of buffer, read new one
+            bufferStart = offset;
+            bufferSize = preadAll(fd_, buffer.data(), buffer.size(), offset);
+            if (bufferSize < sizeof(Block)) { return nullptr; }
+        }
+
+        return reinterpret_cast<const Header*>
+            (buffer.data() + (offset - bufferStart));
+    });
+
+    // overrides from PAX extended header or GNU long name; size is built
+    // with initialized storage to keep -Wmaybe-uninitialized quiet
+    boost::optional<std::string> longPath;
+    auto longSize(boost::make_optional(false, std::size_t()));
+
+    std::size_t offset(0);
+    while (const auto *h = header(offset)) {
+        offset += sizeof(Block);
+
+        if (!h->valid()) { continue; }
+
+        // extended headers carry their own size; overrides apply only to the
+        // following entry
+        switch (*h->typeflag()) {
+        case 'x': {
+            const auto data(readData(offset, h->getSize()));
+            parsePax(data, longPath, longSize);
+            offset += h->getBlocksBytes();
+            continue;
+        }
+
+        case 'L': {
+            const auto data(readData(offset, h->getSize()));
+            longPath = std::string
+                (data.begin(), std::find(data.begin(), data.end(), '\0'));
+            offset += h->getBlocksBytes();
+            continue;
+        }
+
+        default: break;
+        }
+
+        const auto size(longSize ? *longSize : h->getSize());
+
+        if (h->isFile()) {
+            files_.emplace_back(longPath ? fs::path(*longPath) : h->getPath()
+                                , offset, size);
+
+            // apply limit
+            if (files_.size() >= limit) { break; }
+        }
+
+        // skip file/whatever content
+        offset += ((size + 511UL) / 512UL) * 512UL;
+        longPath = boost::none;
+        longSize = boost::none;
+    }
+
+    index_.reserve(files_.size());
+    for (std::size_t i(0), e(files_.size()); i != e; ++i) {
+        index_[files_[i].path.string()] = i;
+    }
+}
+
+const IndexedReader::File* IndexedReader::tryFind(const fs::path &path) const
+{
+    auto findex(index_.find(path.string()));
+    if (findex == index_.end()) { return nullptr; }
+    return &files_[findex->second];
+}
+
+const IndexedReader::File& IndexedReader::find(const fs::path &path) const
+{
+    if (const auto *file = tryFind(path)) { return *file; }
+
+    LOGTHROW(err2, std::runtime_error)
+        << "File " << path << " not found in tar file " << path_ << ".";
+    throw;
+}
+
+Data IndexedReader::readData(const File &file) const
+{
+    return readData(file.start, file.size);
+}
+
+Data IndexedReader::readData(std::size_t start, std::size_t size) const
+{
+    Data data(size, 0);
+    if (preadAll(fd_, data.data(), size, start) != size) {
+        LOGTHROW(err2, std::runtime_error)
+            << "Too few data in " << fd_.path() << " at offset "
+            << start << ".";
+    }
+    return data;
+}
+
+Reader::Filedes IndexedReader::filedes(const File &file) const
+{
+    return { fd_.get(), file.start, file.end() };
+}
+
 namespace {
 
 int flagsToOpenFlags(int inflags)
 {
-    flags = O_WRONLY | O_APPEND;
+    int flags(O_WRONLY);
     if (inflags & Writer::Flags::truncate) { flags |= O_TRUNC; }
     if (inflags & Writer::Flags::create) { flags |= O_CREAT; }
     if (inflags & Writer::Flags::exclusive) { flags |= O_EXCL; }
+    return flags;
+}
+
+/** Maximum value representable by octal field of given size (incl. NUL).
+ */
+constexpr std::uint64_t maxOctal(std::size_t size)
+{
+    return (std::uint64_t(1) << (3 * (size - 1))) - 1;
+}
+
+/** Writes value as zero padded, NUL terminated octal number. Throws when
+ *  value does not fit; callers must use PAX records for larger values.
+ */
+template <std::size_t size>
+void setOctal(char *field, std::uint64_t value)
+{
+    if (value > maxOctal(size)) {
+        LOGTHROW(err2, std::runtime_error)
+            << "Value " << value << " does not fit into " << (size - 1)
+            << "-digit octal field of tar header.";
+    }
+
+    field[size - 1] = '\0';
+    for (std::size_t i(size - 1); i--; value >>= 3) {
+        field[i] = char('0' + (value & 07));
+    }
+}
+
+template <std::size_t size>
+void setString(char *field, const std::string &value)
+{
+    std::memcpy(field, value.data(), std::min(size, value.size()));
+}
+
+void setChecksum(Header &header)
+{
+    std::memset(header.chksum(), ' ', 8);
+
+    unsigned int sum(0);
+    for (auto c : header.data) { sum += static_cast<unsigned char>(c); }
+
+    // 6 octal digits, NUL, space
+    setOctal<7>(header.chksum(), sum);
+    header.chksum()[7] = ' ';
+}
+
+/** Tries to split path into ustar prefix and name. Returns false if
+ *  impossible.
+ */
+bool splitPath(const std::string &path, std::string &prefix
+               , std::string &name)
+{
+    if (path.size() <= 100) {
+        prefix.clear();
+        name = path;
+        return true;
+    }
+
+    // find slash separating prefix and name
+    for (auto slash(path.find('/'));
+         slash != std::string::npos;
+         slash = path.find('/', slash + 1))
+    {
+        if (slash > 155) { break; }
+        if ((path.size() - slash - 1) <= 100) {
+            prefix = path.substr(0, slash);
+            name = path.substr(slash + 1);
+            return !name.empty();
+        }
+    }
+
+    return false;
+}
+
+/** Single PAX extended header record: "length key=value\n", where length
+ *  covers the whole record including itself.
+ */
+std::string paxRecord(const std::string &key, const std::string &value)
+{
+    const auto payload(key.size() + value.size() + 3); // space, =, \n
+    auto length(payload + 1);
+    while (std::to_string(length).size() + payload > length) { ++length; }
+    return std::to_string(length) + " " + key + "=" + value + "\n";
+}
+
+Header basicHeader(std::size_t size, std::time_t mtime, unsigned int mode
+                   , char type)
+{
+    Header header;
+    header.data.fill(0);
+
+    setOctal<8>(header.mode(), mode & 07777);
+    setOctal<8>(header.uid(), 0);
+    setOctal<8>(header.gid(), 0);
+    setOctal<12>(header.size(), std::min(std::uint64_t(size)
+                                         , maxOctal(12)));
+    setOctal<12>(header.mtime(), (mtime < 0) ? 0 : mtime);
+    *header.typeflag() = type;
+    std::memcpy(header.magic(), TMAGIC, TMAGLEN);
+    std::memcpy(header.version(), TVERSION, TVERSLEN);
+
+    return header;
 }
 
 } // namespace
 
 Writer::Writer(const boost::filesystem::path &path, int flags)
-    : path_(path), fd_(::open(path.string().c_str(), flagsToOpenFlags(flags))
+    : path_(path), fd_(::open(path.string().c_str(), flagsToOpenFlags(flags)
+                              , (S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH))
                        , path)
 {
     if (!fd_) {
@@ -262,18 +583,230 @@ Writer::Writer(const boost::filesystem::path &path, int flags)
         throw e;
     }
 
-    // TODO: handle 
+    // not truncated: append at the end
+    if (-1 == ::lseek(fd_, 0, SEEK_END)) {
+        std::system_error e(errno, std::system_category());
+        LOG(err2) << "Cannot seek in tar file " << fd_.path() << ": <"
+                  << e.code() << ", " << e.what() << ">.";
+        throw e;
+    }
+}
+
+void Writer::writeRaw(const void *data, std::size_t size)
+{
+    const auto *p(static_cast<const char*>(data));
+    while (size) {
+        auto bytes(TEMP_FAILURE_RETRY(::write(fd_, p, size)));
+        if (bytes == -1) {
+            std::system_error e(errno, std::system_category());
+            LOG(err2) << "Cannot write to tar file " << fd_.path() << ": <"
+                      << e.code() << ", " << e.what() << ">.";
+            throw e;
+        }
+
+        size -= bytes;
+        p += bytes;
+    }
+}
+
+void Writer::pad(std::size_t size)
+{
+    static const Block zero = {{}};
+    if (const auto rest = (size % zero.data.size())) {
+        writeRaw(zero.data.data(), zero.data.size() - rest);
+    }
+}
+
+void Writer::writeHeader(const Header &header)
+{
+    Header h(header);
+    setChecksum(h);
+    writeRaw(h.data.data(), h.data.size());
 }
 
-void Writer::write(const Header &header, std::size_t block, std::size_t size)
+void Writer::writeHeader(const boost::filesystem::path &path
+                         , std::size_t size, std::time_t mtime
+                         , unsigned int mode)
 {
-    
+    const auto p(path.generic_string());
+
+    auto header(basicHeader(size, mtime, mode, REGTYPE));
+
+    std::string extended;
+
+    std::string prefix, name;
+    if (splitPath(p, prefix, name)) {
+        setString<155>(header.prefix(), prefix);
+        setString<100>(header.name(), name);
+    } else {
+        // path too long: use truncated name and full path in PAX header
+        setString<100>(header.name(), p);
+        extended += paxRecord("path", p);
+    }
+
+    if (size > maxOctal(12)) {
+        extended += paxRecord("size", std::to_string(size));
+    }
+
+    if (!extended.empty()) {
+        // PAX extended header for the following file
+        auto pax(basicHeader(extended.size(), mtime, 0644, 'x'));
+        setString<100>(pax.name(), "PaxHeader/"
+                       + path.filename().string().substr(0, 90));
+        writeHeader(pax);
+        writeRaw(extended.data(), extended.size());
+        pad(extended.size());
+    }
+
+    writeHeader(header);
 }
 
-void Writer::write(const Header &header, const boost::filesystem &file)
+void Writer::write(const Header &header, const void *data, std::size_t size)
 {
-    
+    writeHeader(header);
+    writeRaw(data, size);
+    pad(size);
 }
+
+void Writer::write(const boost::filesystem::path &path, const void *data
+                   , std::size_t size, std::time_t mtime)
+{
+    writeHeader(path, size, (mtime < 0) ? std::time(nullptr) : mtime, 0644);
+    writeRaw(data, size);
+    pad(size);
+}
+
+void Writer::write(const boost::filesystem::path &path, std::istream &is
+                   , std::size_t size, std::time_t mtime)
+{
+    writeHeader(path, size, (mtime < 0) ? std::time(nullptr) : mtime, 0644);
+
+    std::vector<char> buffer(CopyBufferSize);
+    for (auto left(size); left; ) {
+        const auto chunk(std::min(left, buffer.size()));
+        if (!is.read(buffer.data(), chunk)) {
+            LOGTHROW(err2, std::runtime_error)
+                << "Too few data in input stream for file " << path
+                << " in tar file " << fd_.path() << ".";
+        }
+        writeRaw(buffer.data(), chunk);
+        left -= chunk;
+    }
+
+    pad(size);
+}
+
+void Writer::write(const Header &header, const boost::filesystem::path &file)
+{
+    utility::Filedes src(::open(file.string().c_str(), O_RDONLY), file);
+    if (!src) {
+        std::system_error e(errno, std::system_category());
+        LOG(err2) << "Cannot open file " << file << ": <"
+                  << e.code() << ", " << e.what() << ">.";
+        throw e;
+    }
+
+    writeHeader(header);
+    copy(src, header.getSize());
+}
+
+void Writer::write(const boost::filesystem::path &path
+                   , const boost::filesystem::path &file)
+{
+    utility::Filedes src(::open(file.string().c_str(), O_RDONLY), file);
+    if (!src) {
+        std::system_error e(errno, std::system_category());
+        LOG(err2) << "Cannot open file " << file << ": <"
+                  << e.code() << ", " << e.what() << ">.";
+        throw e;
+    }
+
+    struct ::stat st;
+    if (-1 == ::fstat(src, &st)) {
+        std::system_error e(errno, std::system_category());
+        LOG(err2) << "Cannot stat file " << file << ": <"
+                  << e.code() << ", " << e.what() << ">.";
+        throw e;
+    }
+
+    writeHeader(path, st.st_size, st.st_mtime, st.st_mode);
+    copy(src, st.st_size);
+}
+
+void Writer::copy(const utility::Filedes &src, std::size_t size)
+{
+    auto left(size);
+
+#ifdef __linux__
+    // try in-kernel copy first: copy_file_range (same filesystem, may even
+    // share extents) and then sendfile
+    for (bool useCopyFileRange(true); left; ) {
+        ::ssize_t bytes;
+        if (useCopyFileRange) {
+            bytes = ::copy_file_range(src, nullptr, fd_, nullptr, left, 0);
+            if ((bytes == -1)
+                && ((errno == EXDEV) || (errno == ENOSYS)
+                    || (errno == EINVAL) || (errno == EOPNOTSUPP)))
+            {
+                useCopyFileRange = false;
+                continue;
+            }
+        } else {
+            bytes = ::sendfile(fd_, src, nullptr, left);
+            if ((bytes == -1) && ((errno == EINVAL) || (errno == ENOSYS))) {
+                // fallback to userspace copy
+                break;
+            }
+        }
+
+        if (bytes == -1) {
+            if (errno == EINTR) { continue; }
+            std::system_error e(errno, std::system_category());
+            LOG(err2) << "Cannot copy file " << src.path()
+                      << " to tar file " << fd_.path() << ": <"
+                      << e.code() << ", " << e.what() << ">.";
+            throw e;
+        }
+
+        // premature EOF
+        if (!bytes) { break; }
+        left -= bytes;
+    }
 #endif
 
+    // userspace copy of the rest (if any)
+    std::vector<char> buffer(CopyBufferSize);
+    while (left) {
+        auto bytes(TEMP_FAILURE_RETRY
+                   (::read(src, buffer.data()
+                           , std::min(left, buffer.size()))));
+        if (bytes == -1) {
+            std::system_error e(errno, std::system_category());
+            LOG(err2) << "Cannot read from file " << src.path() << ": <"
+                      << e.code() << ", " << e.what() << ">.";
+            throw e;
+        }
+
+        if (!bytes) { break; }
+        writeRaw(buffer.data(), bytes);
+        left -= bytes;
+    }
+
+    if (left) {
+        LOGTHROW(err2, std::runtime_error)
+            << "File " << src.path() << " is shorter than expected "
+            << size << " bytes; archive " << fd_.path() << " is corrupted.";
+    }
+
+    pad(size);
+}
+
+void Writer::end()
+{
+    // two zero blocks
+    static const Block zero = {{}};
+    writeRaw(zero.data.data(), zero.data.size());
+    writeRaw(zero.data.data(), zero.data.size());
+}
+
 } } // namespace utility::tar
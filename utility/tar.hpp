@@ -28,7 +28,11 @@
 
 #include <ctime>
 #include <array>
+#include <iosfwd>
 #include <limits>
+#include <vector>
+#include <string>
+#include <unordered_map>
 
 #include <boost/filesystem/path.hpp>
 
@@ -170,6 +174,10 @@ public:
         {}
     };
 
+    /** Scans the archive from the start and returns regular files. PAX
+     *  extended headers (path and size records) and GNU long names are
+     *  honoured.
+     */
     File::list files(std::size_t limit
                      = std::numeric_limits<std::size_t>::max());
 
@@ -183,6 +191,60 @@ private:
     std::size_t cursor_;
 };
 
+/** Read-only indexed tar archive.
+ *
+ *  File list is built in constructor by scanning headers using large buffered
+ *  reads; file content is read via pread(2). No member function touches file
+ *  offset or other mutable state, therefore single instance can be used
+ *  from multiple threads without any locking.
+ */
+class IndexedReader {
+public:
+    typedef Reader::File File;
+
+    IndexedReader(const boost::filesystem::path &path
+                  , std::size_t limit
+                  = std::numeric_limits<std::size_t>::max());
+
+    const File::list& files() const { return files_; }
+
+    /** Finds file by path. Throws std::runtime_error when not found.
+     */
+    const File& find(const boost::filesystem::path &path) const;
+
+    /** Finds file by path. Returns nullptr when not found.
+     */
+    const File* tryFind(const boost::filesystem::path &path) const;
+
+    /** Reads whole file content.
+     */
+    Data readData(const File &file) const;
+
+    /** Reads given amount of bytes starting at given byte offset.
+     */
+    Data readData(std::size_t start, std::size_t size) const;
+
+    /** Return file descriptor for given file.
+     */
+    Reader::Filedes filedes(const File &file) const;
+
+    int filedes() const { return fd_; }
+
+    const boost::filesystem::path& path() const { return path_; }
+
+private:
+    boost::filesystem::path path_;
+
+    utility::Filedes fd_;
+
+    File::list files_;
+
+    /** Path to index into files_ mapping. Last file wins (i.e. the same
+     *  semantics as tar extraction).
+     */
+    std::unordered_map<std::string, std::size_t> index_;
+};
+
 class Writer {
 public:
     enum Flags {
@@ -191,11 +253,46 @@ public:
         , exclusive = 0x04
     };
 
+    /** Opens tar file for writing. Without Flags::truncate new files are
+     *  appended at the end of the file; any existing terminator must be
+     *  removed beforehand.
+     */
     Writer(const boost::filesystem::path &path
            , int flags = Flags::create | Flags::exclusive | Flags::truncate);
 
-    void write(const Header &header, std::size_t block, std::size_t size);
+    /** Writes regular file from memory.
+     *
+     * Path not fitting into ustar header (as well as size over 8 GB) is
+     * stored in PAX extended header.
+     *
+     * \param path path inside archive
+     * \param data file content
+     * \param size file size
+     * \param mtime modification time, current time if negative
+     */
+    void write(const boost::filesystem::path &path, const void *data
+               , std::size_t size, std::time_t mtime = -1);
+
+    /** Writes regular file from stream. Exactly size bytes are read.
+     */
+    void write(const boost::filesystem::path &path, std::istream &is
+               , std::size_t size, std::time_t mtime = -1);
 
+    /** Writes regular file with content copied from given file. Data are
+     *  copied in kernel (copy_file_range/sendfile) when possible. Size,
+     *  modification time and mode are taken from the file.
+     */
+    void write(const boost::filesystem::path &path
+               , const boost::filesystem::path &file);
+
+    /** Writes raw header followed by data from memory. Header checksum is
+     *  computed by writer.
+     */
+    void write(const Header &header, const void *data, std::size_t size);
+
+    /** Writes raw header followed by header.getSize() bytes copied from
+     *  given file. Header checksum is computed by writer.
+     */
     void write(const Header &header, const boost::filesystem::path &file);
 
     /** Write file terminator
@@ -203,6 +300,21 @@ public:
     void end();
 
 private:
+    void writeRaw(const void *data, std::size_t size);
+
+    /** Pads data of given size to block boundary.
+     */
+    void pad(std::size_t size);
+
+    void writeHeader(const Header &header);
+
+    void writeHeader(const boost::filesystem::path &path, std::size_t size
+                     , std::time_t mtime, unsigned int mode);
+
+    void copy(const utility::Filedes &src, std::size_t size);
+
+    static constexpr std::size_t CopyBufferSize = 1 << 16;
+
     boost::filesystem::path path_;
 
     utility::Filedes fd_;
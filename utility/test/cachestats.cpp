@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <chrono>
+#include <ctime>
+#include <sstream>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../cachestats.hpp"
+
+#include "dbglog/dbglog.hpp"
+
+BOOST_AUTO_TEST_CASE(utility_cachestats_window)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/CacheStatsWindow.");
+
+    utility::CacheStatsWindow window({ 2, 10 });
+
+    utility::CacheStats stats;
+    stats.hits = 3;
+    stats.misses = 1;
+    window.update(stats);
+
+    // current second is not reported, wait for the next one
+    const auto start(std::time(nullptr));
+    while (std::time(nullptr) == start) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::ostringstream os;
+    window.report(os, "cache.");
+    const auto report(os.str());
+    BOOST_TEST_MESSAGE(report);
+
+    for (const auto *line : { "cache.hits.total.2=3\n"
+                , "cache.hits.total.10=3\n", "cache.misses.total.10=1\n"
+                , "cache.hitRatio.2=0.75\n", "cache.hitRatio.10=0.75\n" })
+    {
+        BOOST_CHECK_MESSAGE(report.find(line) != std::string::npos
+                            , "missing: " << line);
+    }
+
+    // only configured windows are reported
+    BOOST_CHECK(report.find(".5=") == std::string::npos);
+    BOOST_CHECK(report.find(".300=") == std::string::npos);
+}
@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../cachingresourcefetcher.hpp"
+
+#include "dbglog/dbglog.hpp"
+
+namespace {
+
+typedef utility::ResourceFetcher::Query Query;
+typedef utility::ResourceFetcher::MultiQuery MultiQuery;
+
+/** Backend that answers every query immediately and counts fetches.
+ */
+struct CountingFetcher : utility::ResourceFetcher {
+    mutable std::atomic<int> fetched;
+    std::time_t expires;
+
+    CountingFetcher(std::time_t expires) : fetched(0), expires(expires) {}
+
+    virtual void perform_impl(MultiQuery query, const Done &done) const {
+        for (auto &q : query) {
+            ++fetched;
+            if (q.location() == "missing") {
+                q.error(make_error_code
+                        (std::errc::no_such_file_or_directory));
+                continue;
+            }
+            const auto &data(q.location());
+            q.set(0, expires, data.data(), data.size(), "text/plain");
+        }
+        done(std::move(query));
+    }
+};
+
+/** Backend that answers with wrong number of queries.
+ */
+struct SloppyFetcher : utility::ResourceFetcher {
+    bool extra;
+
+    SloppyFetcher(bool extra) : extra(extra) {}
+
+    virtual void perform_impl(MultiQuery query, const Done &done) const {
+        MultiQuery answer;
+        for (auto &q : query) {
+            q.set(0, -1, "x", 1, "text/plain");
+            answer.add(std::move(q));
+            if (!extra) { break; }
+        }
+        if (extra) { answer.add(Query("extra")); }
+        done(std::move(answer));
+    }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(utility_cachingresourcefetcher)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/CachingResourceFetcher.");
+
+    auto backend(std::make_shared<CountingFetcher>
+                 (std::time(nullptr) + 3600));
+    utility::CachingResourceFetcher fetcher(backend, 1 << 20);
+
+    // duplicate queries in one batch are fetched once
+    MultiQuery mq;
+    mq.add(Query("a"));
+    mq.add(Query("b"));
+    mq.add(Query("a"));
+    mq.add(Query("missing"));
+    mq = fetcher.perform(std::move(mq));
+    BOOST_CHECK_EQUAL(backend->fetched, 3);
+    BOOST_CHECK_EQUAL(mq[0].get().data, "a");
+    BOOST_CHECK_EQUAL(mq[1].get().data, "b");
+    BOOST_CHECK_EQUAL(mq[2].get().data, "a");
+    BOOST_CHECK(!mq[3].valid());
+
+    // coalesced queries share the same payload memory
+    BOOST_CHECK(mq[0].get().data.data() == mq[2].get().data.data());
+
+    // cached bodies are served without backend; errors are not cached
+    BOOST_CHECK_EQUAL(fetcher.perform(Query("b")).get().data, "b");
+    BOOST_CHECK_EQUAL(backend->fetched, 3);
+    BOOST_CHECK(!fetcher.perform(Query("missing")).valid());
+    BOOST_CHECK_EQUAL(backend->fetched, 4);
+
+    // already expired bodies are never cached
+    backend->expires = 1;
+    fetcher.perform(Query("c"));
+    fetcher.perform(Query("c"));
+    BOOST_CHECK_EQUAL(backend->fetched, 6);
+    BOOST_CHECK_EQUAL(fetcher.perform(Query("c")).get().data, "c");
+
+    // uncacheable results are passed through, not counted as failures
+    BOOST_CHECK_EQUAL(fetcher.stats().failures, 0);
+}
+
+BOOST_AUTO_TEST_CASE(utility_cachingresourcefetcher_sloppy_backend)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/CachingResourceFetcher with"
+                       " backend returning wrong number of queries.");
+
+    for (bool extra : { false, true }) {
+        utility::CachingResourceFetcher fetcher
+            (std::make_shared<SloppyFetcher>(extra), 1 << 20);
+
+        MultiQuery mq;
+        mq.add(Query("a"));
+        mq.add(Query("b"));
+        mq = fetcher.perform(std::move(mq));
+        BOOST_REQUIRE_EQUAL(mq.size(), 2);
+        BOOST_CHECK_EQUAL(mq[0].get().data, "x");
+        BOOST_CHECK_EQUAL(mq[1].valid(), extra);
+    }
+}
@@ -0,0 +1,230 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "../clockcache.hpp"
+#include "../lrucache.hpp"
+
+#include "dbglog/dbglog.hpp"
+
+namespace {
+
+struct Item {
+    int key;
+    std::size_t cost;
+
+    Item(int key, std::size_t cost = 1) : key(key), cost(cost) {}
+};
+
+typedef std::shared_ptr<Item> ItemPointer;
+
+/** Runs op(thread, i) in given number of threads for a while. Returns number
+ *  of operations per second.
+ */
+template <typename Op>
+double throughput(int threadCount, const Op &op)
+{
+    std::atomic<bool> running(true);
+    std::atomic<std::uint64_t> total(0);
+
+    std::vector<std::thread> threads;
+    for (int t(0); t < threadCount; ++t) {
+        threads.emplace_back([&, t]()
+        {
+            std::uint64_t count(0);
+            while (running) {
+                for (int i(0); i < 1000; ++i) { op(t, i); }
+                count += 1000;
+            }
+            total += count;
+        });
+    }
+
+    const std::chrono::milliseconds duration(200);
+    std::this_thread::sleep_for(duration);
+    running = false;
+    for (auto &thread : threads) { thread.join(); }
+
+    return total * 1000.0 / duration.count();
+}
+
+} // namespace
+
+namespace utility {
+
+template <> struct LruCacheTraits<Item> {
+    static int key(const Item &item) { return item.key; }
+    static std::size_t cost(const Item &item) { return item.cost; }
+};
+
+} // namespace utility
+
+BOOST_AUTO_TEST_CASE(utility_clockcache_second_chance)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/ClockCache second chance.");
+
+    utility::ClockCache<Item> cache;
+    for (int i(1); i <= 4; ++i) {
+        BOOST_REQUIRE(cache.insert(std::make_shared<Item>(i)));
+    }
+    BOOST_CHECK(!cache.insert(std::make_shared<Item>(1)));
+    BOOST_CHECK_EQUAL(cache.totalCost(), 4);
+
+    // referenced entries survive the sweep
+    cache.get(1);
+    cache.get(3);
+    BOOST_CHECK_EQUAL(cache.trim(3), 1);
+    BOOST_CHECK_EQUAL(cache.totalCost(), 3);
+    BOOST_CHECK(!cache.get(2));
+
+    // hand points at 4 (moved into the freed slot), never referenced
+    BOOST_CHECK_EQUAL(cache.trim(2), 1);
+    BOOST_CHECK(!cache.get(4));
+    BOOST_CHECK(cache.get(1));
+    BOOST_CHECK(cache.get(3));
+
+    // all referenced: full turn clears bits, then evicts
+    BOOST_CHECK_EQUAL(cache.trim(1), 1);
+    BOOST_CHECK_EQUAL(cache.totalCost(), 1);
+
+    // no-op trim
+    BOOST_CHECK_EQUAL(cache.trim(1), 0);
+
+    // empty the cache
+    BOOST_CHECK_EQUAL(cache.trim(0), 1);
+    BOOST_CHECK_EQUAL(cache.totalCost(), 0);
+    BOOST_CHECK(!cache.get(1));
+    BOOST_CHECK(!cache.get(3));
+}
+
+BOOST_AUTO_TEST_CASE(utility_clockcache_cost)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/ClockCache cost accounting.");
+
+    utility::ClockCache<Item> cache;
+    cache.insert(std::make_shared<Item>(1, 10));
+    cache.insert(std::make_shared<Item>(2, 20));
+    cache.insert(std::make_shared<Item>(3, 30));
+    BOOST_CHECK_EQUAL(cache.totalCost(), 60);
+
+    // rejected insert does not change the cost
+    cache.insert(std::make_shared<Item>(2, 100));
+    BOOST_CHECK_EQUAL(cache.totalCost(), 60);
+    BOOST_CHECK_EQUAL(cache.get(2)->cost, 20);
+
+    // evicts unreferenced entries until under the limit
+    cache.trim(45);
+    BOOST_CHECK(cache.totalCost() <= 45);
+    BOOST_CHECK(cache.get(2));
+}
+
+BOOST_AUTO_TEST_CASE(utility_clockcache_concurrent)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/ClockCache concurrent access.");
+
+    utility::ClockCache<Item> cache;
+    for (int i(0); i < 100; ++i) {
+        cache.insert(std::make_shared<Item>(i));
+    }
+
+    std::atomic<bool> running(true);
+    std::atomic<int> errors(0);
+    std::atomic<int> hits(0);
+
+    // readers share the lock
+    std::vector<std::thread> threads;
+    for (int t(0); t < 8; ++t) {
+        threads.emplace_back([&]()
+        {
+            while (running) {
+                for (int i(0); i < 100; ++i) {
+                    if (auto item = cache.get(i)) {
+                        if (item->key != i) { ++errors; }
+                        ++hits;
+                    }
+                }
+            }
+        });
+    }
+
+    // writer inserts and trims at the same time
+    for (int i(100); i < 10000; ++i) {
+        cache.insert(std::make_shared<Item>(i));
+        if (!(i % 10)) { cache.trim(150); }
+    }
+    running = false;
+    for (auto &thread : threads) { thread.join(); }
+
+    BOOST_CHECK_EQUAL(errors, 0);
+    BOOST_CHECK(hits > 0);
+    BOOST_CHECK(cache.totalCost() <= 160);
+}
+
+BOOST_AUTO_TEST_CASE(utility_clockcache_contention)
+{
+    BOOST_TEST_MESSAGE("* Benchmarking utility/ClockCache read contention.");
+
+    // reports reads per second; timing depends on the box, nothing checked
+    const int threads(std::max(2u, std::thread::hardware_concurrency()));
+
+    utility::ClockCache<Item> clock;
+    utility::LruCache<Item> lru;
+    for (int i(0); i < 1000; ++i) {
+        clock.insert(std::make_shared<Item>(i));
+        lru.insert(std::make_shared<Item>(i));
+    }
+
+    std::shared_timed_mutex stdMutex;
+    boost::shared_mutex boostMutex;
+
+    const auto report([&](const char *what, const auto &op)
+    {
+        const auto single(throughput(1, op));
+        const auto multi(throughput(threads, op));
+        BOOST_CHECK((single > 0) && (multi > 0));
+        BOOST_TEST_MESSAGE("    " << what << ": " << single << " ops/s in 1 "
+                           "thread, " << multi << " ops/s in " << threads
+                           << " threads (" << (multi / single) << "x)");
+    });
+
+    report("ClockCache::get", [&](int, int i) { clock.get(i); });
+    report("LruCache::get", [&](int, int i) { lru.get(i); });
+    report("std::shared_timed_mutex shared lock", [&](int, int)
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(stdMutex);
+    });
+    report("boost::shared_mutex shared lock", [&](int, int)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(boostMutex);
+    });
+}
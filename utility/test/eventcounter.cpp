@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../eventcounter.hpp"
+
+#include "dbglog/dbglog.hpp"
+
+BOOST_AUTO_TEST_CASE(utility_shardedeventcounter)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/ShardedEventCounter.");
+
+    // 20 ms slots, 4 shards
+    utility::ShardedEventCounter counter
+        (100, std::chrono::milliseconds(20), 4);
+
+    std::vector<std::thread> threads;
+    for (int t(0); t < 8; ++t) {
+        threads.emplace_back([&counter]()
+        {
+            for (int i(0); i < 10000; ++i) { counter.event(); }
+        });
+    }
+    for (auto &thread : threads) { thread.join(); }
+
+    // let current slot become past one
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    BOOST_CHECK_EQUAL(counter.total(1), 80000);
+    BOOST_CHECK(counter.max(1) <= 80000);
+    BOOST_CHECK(counter.max(1) > 0);
+    BOOST_CHECK_CLOSE(counter.average(1), 80000.0, 1e-6);
+}
@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <thread>
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../histogram.hpp"
+
+#include "dbglog/dbglog.hpp"
+
+BOOST_AUTO_TEST_CASE(utility_windowedhistogram_buckets)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/WindowedHistogram buckets.");
+
+    typedef utility::WindowedHistogram H;
+
+    // every value fits into its bucket with bounded relative error
+    for (std::uint64_t v(0); v < 100000; v += 7) {
+        const auto b(H::bucket(v));
+        BOOST_REQUIRE(b < H::BucketCount);
+        BOOST_REQUIRE(H::upperBound(b) >= v);
+        BOOST_REQUIRE(!b || (H::upperBound(b - 1) < v));
+        BOOST_REQUIRE(H::upperBound(b) <= v + v / 8);
+    }
+    BOOST_CHECK_EQUAL(H::bucket(std::uint64_t(1) << 40), H::BucketCount - 1);
+}
+
+BOOST_AUTO_TEST_CASE(utility_windowedhistogram)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/WindowedHistogram.");
+
+    utility::WindowedHistogram histogram(10);
+
+    // wait for start of a second so all values land in one slot
+    const auto start(std::time(nullptr));
+    while (std::time(nullptr) == start) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    for (std::uint64_t v(1); v <= 1000; ++v) { histogram.record(v); }
+
+    // let current slot become past one
+    const auto recorded(std::time(nullptr));
+    while (std::time(nullptr) == recorded) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    BOOST_CHECK_EQUAL(histogram.total(5), 1000);
+
+    const auto p50(histogram.quantile(.5, 5));
+    BOOST_CHECK(p50 >= 500 && p50 <= 500 + 500 / 8);
+    const auto p99(histogram.quantile(.99, 5));
+    BOOST_CHECK(p99 >= 990 && p99 <= 990 + 990 / 8);
+
+    std::ostringstream os;
+    histogram.quantiles(os, "latency.", { 5 });
+    BOOST_CHECK(os.str().find("latency.p99.5=") != std::string::npos);
+    BOOST_CHECK(os.str().find("latency.p999.5=") != std::string::npos);
+}
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "../localresourcefetcher.hpp"
+#include "../streams.hpp"
+#include "../zip.hpp"
+
+#include "dbglog/dbglog.hpp"
+
+namespace fs = boost::filesystem;
+
+BOOST_AUTO_TEST_CASE(utility_localresourcefetcher)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/LocalResourceFetcher.");
+
+    typedef utility::ResourceFetcher::Query Query;
+
+    const auto root(fs::temp_directory_path()
+                    / fs::unique_path("localresourcefetcher-%%%%-%%%%"));
+    fs::create_directories(root);
+
+    utility::write(root / "plain.txt", "plain", 5);
+    {
+        utility::zip::Writer zip(root / "archive.zip");
+        const auto add([&](const char *path, const char *data)
+        {
+            auto os(zip.ostream(path));
+            os->get() << data;
+            os->close();
+        });
+        add("/a.json", "{}");
+        add("/b.txt", "bbb");
+        zip.close();
+    }
+
+    utility::LocalResourceFetcher::Config config;
+    config.threads = 2;
+    config.maxAge = 60;
+    utility::LocalResourceFetcher fetcher(config);
+
+    const auto archive("zip://" + (root / "archive.zip").string());
+    utility::ResourceFetcher::MultiQuery mq;
+    mq.add(Query("file://" + (root / "plain.txt").string()));
+    mq.add(Query(archive + "#/a.json"));
+    mq.add(Query(archive + "#/b.txt"));
+    mq.add(Query(archive + "#/missing"));
+    mq.add(Query("file://" + (root / "missing").string()));
+    mq.add(Query("http://example.com/"));
+    mq = fetcher.perform(std::move(mq));
+
+    BOOST_CHECK_EQUAL(mq[0].get().data, "plain");
+    BOOST_CHECK_EQUAL(mq[0].get().contentType, "text/plain");
+    BOOST_CHECK(mq[0].get().expires > 0);
+    BOOST_CHECK_EQUAL(mq[1].get().data, "{}");
+    BOOST_CHECK_EQUAL(mq[1].get().contentType, "application/json");
+    BOOST_CHECK_EQUAL(mq[2].get().data, "bbb");
+    BOOST_CHECK(mq[3].ec() == utility::HttpCode::NotFound);
+    BOOST_CHECK(mq[4].ec() == utility::HttpCode::NotFound);
+    BOOST_CHECK(mq[5].ec() == utility::HttpCode::BadRequest);
+
+    // zip archive opened as tar must not be served by zip reader
+    const auto tar("tar://" + (root / "archive.zip").string());
+    BOOST_CHECK(!fetcher.perform(Query(tar + "#/b.txt")).valid());
+    BOOST_CHECK_EQUAL(fetcher.perform(Query(archive + "#/b.txt")).get().data
+                      , "bbb");
+
+    fs::remove_all(root);
+}
@@ -0,0 +1,407 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../lrucache2.hpp"
+
+#include "dbglog/dbglog.hpp"
+
+namespace {
+
+typedef std::shared_ptr<std::string> StringPointer;
+
+std::tuple<StringPointer, std::size_t> load(int key)
+{
+    return std::make_tuple(std::make_shared<std::string>
+                           (std::to_string(key)), std::size_t(10));
+}
+
+/** Queue running posted operations on demand.
+ */
+struct ManualQueue : utility::AsyncQueue {
+    mutable std::vector<Operation> ops;
+
+    void run() {
+        std::vector<Operation> current;
+        std::swap(current, ops);
+        for (const auto &op : current) { op(); }
+    }
+
+private:
+    void post_impl(const Operation &op) const override { ops.push_back(op); }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(utility_lrucache2_sharded)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/ShardedLruCache2.");
+
+    utility::ShardedLruCache2<int, std::string> cache(1000, 8);
+    BOOST_CHECK_EQUAL(cache.shardCount(), 8);
+
+    // concurrent access: every key must be loaded only once
+    std::atomic<int> loads(0);
+    std::atomic<int> errors(0);
+    std::vector<std::thread> threads;
+    for (int t(0); t < 8; ++t) {
+        threads.emplace_back([&]()
+        {
+            for (int i(0); i < 1000; ++i) {
+                const auto key(i % 50);
+                auto value(cache.get(key, [&](int key)
+                {
+                    ++loads;
+                    return load(key);
+                }));
+                if (*value != std::to_string(key)) { ++errors; }
+            }
+        });
+    }
+    for (auto &thread : threads) { thread.join(); }
+
+    BOOST_CHECK_EQUAL(errors, 0);
+    BOOST_CHECK_EQUAL(loads, 50);
+    BOOST_CHECK_EQUAL(cache.totalCost(), 500);
+
+    // each shard holds at most 1/8 of the limit
+    cache.trim(80);
+    BOOST_CHECK(cache.totalCost() <= 80);
+}
+
+BOOST_AUTO_TEST_CASE(utility_lrucache2_sharded_item_cost)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/ShardedLruCache2 item cost.");
+
+    // per-shard share (1) is below item cost (10) -> nothing is retained
+    utility::ShardedLruCache2<int, std::string> unclamped(8, 8);
+    BOOST_CHECK_EQUAL(unclamped.shardCount(), 8);
+    unclamped.get(1, load);
+    BOOST_CHECK_EQUAL(unclamped.totalCost(), 0);
+
+    // shard count clamped so that a single item fits in a shard
+    utility::ShardedLruCache2<int, std::string> clamped(25, 8, 10);
+    BOOST_CHECK_EQUAL(clamped.shardCount(), 2);
+    clamped.get(1, load);
+    BOOST_CHECK_EQUAL(clamped.totalCost(), 10);
+
+    // never below a single shard
+    utility::ShardedLruCache2<int, std::string> single(5, 8, 10);
+    BOOST_CHECK_EQUAL(single.shardCount(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(utility_lrucache2_async)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/LruCache2 asynchronous load.");
+
+    typedef utility::LruCache2<int, std::string> Cache;
+    Cache cache(1000);
+
+    // loader only remembers the completion handler
+    std::mutex mutex;
+    std::vector<Cache::LoadDone> pending;
+    std::atomic<int> loads(0);
+    const auto loader([&](int, Cache::LoadDone done)
+    {
+        ++loads;
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(done);
+    });
+
+    std::atomic<int> values(0);
+    std::atomic<int> errors(0);
+    const Cache::Callback callback([&](const Cache::expected_value &value)
+    {
+        try {
+            if (*value.get() == "ok") { ++values; }
+        } catch (const std::runtime_error&) {
+            ++errors;
+        }
+    });
+
+    // concurrent requests for the same key
+    const auto request([&](int key)
+    {
+        std::vector<std::thread> threads;
+        for (int t(0); t < 8; ++t) {
+            threads.emplace_back([&]()
+            {
+                for (int i(0); i < 10; ++i) {
+                    cache.getAsync(key, loader, callback);
+                }
+            });
+        }
+        for (auto &thread : threads) { thread.join(); }
+    });
+
+    // successful load: loader runs once, every waiter gets the value
+    request(1);
+    BOOST_CHECK_EQUAL(loads, 1);
+    BOOST_REQUIRE_EQUAL(pending.size(), 1);
+    BOOST_CHECK_EQUAL(values, 0);
+    std::thread([&]()
+    {
+        pending.back()(std::make_shared<std::string>("ok"), 10);
+    }).join();
+    BOOST_CHECK_EQUAL(values, 80);
+    BOOST_CHECK_EQUAL(cache.totalCost(), 10);
+
+    // cached now
+    cache.getAsync(1, loader, callback);
+    BOOST_CHECK_EQUAL(loads, 1);
+    BOOST_CHECK_EQUAL(values, 81);
+
+    // failed load: error reaches every waiter, nothing is cached
+    pending.clear();
+    request(2);
+    BOOST_CHECK_EQUAL(loads, 2);
+    BOOST_REQUIRE_EQUAL(pending.size(), 1);
+    std::thread([&]()
+    {
+        pending.back()(std::make_exception_ptr
+                       (std::runtime_error("failed")));
+    }).join();
+    BOOST_CHECK_EQUAL(errors, 80);
+    BOOST_CHECK_EQUAL(cache.totalCost(), 10);
+    BOOST_CHECK_EQUAL(cache.stats().failures, 1);
+
+    // next request starts a new load
+    pending.clear();
+    cache.getAsync(2, loader, callback);
+    BOOST_CHECK_EQUAL(loads, 3);
+    BOOST_REQUIRE_EQUAL(pending.size(), 1);
+    pending.back()(std::make_shared<std::string>("ok"), 10);
+    BOOST_CHECK_EQUAL(values, 82);
+    BOOST_CHECK_EQUAL(cache.totalCost(), 20);
+
+    // uncacheable value: every waiter gets it, not stored, not a failure
+    pending.clear();
+    request(3);
+    BOOST_CHECK_EQUAL(loads, 4);
+    BOOST_REQUIRE_EQUAL(pending.size(), 1);
+    pending.back().uncached(std::make_shared<std::string>("ok"));
+    BOOST_CHECK_EQUAL(values, 162);
+    BOOST_CHECK_EQUAL(cache.totalCost(), 20);
+    BOOST_CHECK_EQUAL(cache.stats().failures, 1);
+    BOOST_CHECK_EQUAL(cache.stats().items, 2);
+}
+
+BOOST_AUTO_TEST_CASE(utility_lrucache2_wait)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/LruCache2 blocking wait.");
+
+    utility::LruCache2<int, std::string> cache(1000);
+
+    std::atomic<int> loads(0);
+    std::atomic<int> errors(0);
+    std::atomic<bool> release(false);
+
+    // slow load of key 1; waiters must not be confused by other loads
+    const auto slow([&](int key)
+    {
+        ++loads;
+        while (!release) { std::this_thread::yield(); }
+        return load(key);
+    });
+
+    std::vector<std::thread> threads;
+    for (int t(0); t < 4; ++t) {
+        threads.emplace_back([&]()
+        {
+            if (*cache.get(1, slow) != "1") { ++errors; }
+        });
+    }
+
+    // other keys load (and fail) meanwhile
+    for (int i(2); i < 50; ++i) {
+        cache.get(i, load);
+        BOOST_CHECK_THROW(cache.get(-i, [](int) -> decltype(load(0))
+        {
+            throw std::runtime_error("failed");
+        }), std::runtime_error);
+    }
+
+    release = true;
+    for (auto &thread : threads) { thread.join(); }
+
+    BOOST_CHECK_EQUAL(errors, 0);
+    BOOST_CHECK_EQUAL(loads, 1);
+
+    // failed load wakes its waiters, one of them loads again
+    loads = 0;
+    std::atomic<int> failures(0);
+    release = false;
+    const auto failing([&](int key)
+    {
+        if (!loads++) {
+            while (!release) { std::this_thread::yield(); }
+            throw std::runtime_error("failed");
+        }
+        return load(key);
+    });
+
+    threads.clear();
+    for (int t(0); t < 4; ++t) {
+        threads.emplace_back([&]()
+        {
+            try {
+                if (*cache.get(100, failing) != "100") { ++errors; }
+            } catch (const std::runtime_error&) {
+                ++failures;
+            }
+        });
+    }
+    while (!loads) { std::this_thread::yield(); }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    release = true;
+    for (auto &thread : threads) { thread.join(); }
+
+    BOOST_CHECK_EQUAL(errors, 0);
+    BOOST_CHECK_EQUAL(failures, 1);
+    BOOST_CHECK_EQUAL(loads, 2);
+}
+
+BOOST_AUTO_TEST_CASE(utility_lrucache2_wtinylfu)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/LruCache2 with W-TinyLFU policy.");
+
+    utility::LruCache2<int, std::string, std::size_t
+                       , utility::WTinyLfuPolicy> cache(100);
+
+    int loads(0);
+    const auto loader([&](int key) { ++loads; return load(key); });
+
+    // hot set, accessed repeatedly
+    for (int round(0); round < 10; ++round) {
+        for (int i(0); i < 5; ++i) { cache.get(i, loader); }
+    }
+
+    // one-off scan must not flush the hot set
+    for (int i(1000); i < 2000; ++i) { cache.get(i, loader); }
+    BOOST_CHECK(cache.totalCost() <= 100);
+
+    loads = 0;
+    for (int i(0); i < 5; ++i) { cache.get(i, loader); }
+    BOOST_CHECK_EQUAL(loads, 0);
+}
+
+BOOST_AUTO_TEST_CASE(utility_lrucache2_stats)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/LruCache2 statistics.");
+
+    utility::LruCache2<int, std::string> cache(50);
+    const auto loader([&](int key) { return load(key); });
+
+    // 7 misses (2 of them evicted), 3 hits
+    for (int i(0); i < 7; ++i) { cache.get(i, loader); }
+    for (int i(4); i < 7; ++i) { cache.get(i, loader); }
+
+    const auto stats(cache.stats());
+    BOOST_CHECK_EQUAL(stats.misses, 7);
+    BOOST_CHECK_EQUAL(stats.hits, 3);
+    BOOST_CHECK_EQUAL(stats.loads, 7);
+    BOOST_CHECK_EQUAL(stats.evictions, 2);
+    BOOST_CHECK_EQUAL(stats.evictedCost, 20);
+    BOOST_CHECK_EQUAL(stats.items, 5);
+    BOOST_CHECK_EQUAL(stats.cost, 50);
+}
+
+BOOST_AUTO_TEST_CASE(utility_lrucache2_expiry)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/LruCache2 expiry.");
+
+    utility::LruCache2<int, std::string> cache(1000);
+    ManualQueue queue;
+    cache.setRefreshQueue(queue);
+
+    int loads(0);
+    std::time_t expires(std::time(nullptr) - 1);
+    const auto loader([&](int key)
+    {
+        ++loads;
+        return std::tuple_cat(load(key), std::make_tuple(expires));
+    });
+
+    // already expired -> removed on next access
+    const auto first(cache.get(1, loader));
+    BOOST_CHECK(cache.get(1, loader) != first);
+    BOOST_CHECK_EQUAL(loads, 2);
+    BOOST_CHECK_EQUAL(cache.stats().expirations, 1);
+
+    // stale value is served and refreshed in the background
+    cache.setStaleWhileRevalidate(3600);
+    expires = std::time(nullptr) + 3600;
+    const auto stale(cache.get(1, loader));
+    BOOST_CHECK_EQUAL(loads, 2);
+    BOOST_CHECK_EQUAL(cache.stats().stale, 1);
+    BOOST_REQUIRE_EQUAL(queue.ops.size(), 1);
+
+    // refresh in progress: stale value, no other refresh
+    BOOST_CHECK(cache.get(1, loader) == stale);
+    BOOST_CHECK_EQUAL(queue.ops.size(), 1);
+
+    queue.run();
+    BOOST_CHECK_EQUAL(loads, 3);
+    BOOST_CHECK(cache.get(1, loader) != stale);
+    BOOST_CHECK_EQUAL(loads, 3);
+    BOOST_CHECK_EQUAL(cache.totalCost(), 10);
+}
+
+BOOST_AUTO_TEST_CASE(utility_lrucache2_refresh_pool)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/LruCache2 background refresh.");
+
+    std::atomic<int> loads(0);
+    {
+        utility::LruCache2<int, std::string> cache(1000);
+        cache.setStaleWhileRevalidate(3600);
+
+        // value captured: refresh may outlive this scope's locals
+        auto *counter(&loads);
+        const auto loader([counter](int key)
+        {
+            ++*counter;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            return std::tuple_cat(load(key), std::make_tuple
+                                  (std::time(nullptr) - 1));
+        });
+
+        cache.get(1, loader);
+        cache.get(1, loader);
+
+        // destructor waits for the refresh running in the shared pool
+    }
+    BOOST_CHECK_EQUAL(loads, 2);
+}
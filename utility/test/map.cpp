@@ -0,0 +1,298 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <type_traits>
+#include <stdexcept>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../map.hpp"
+
+#include "dbglog/dbglog.hpp"
+
+namespace {
+
+typedef std::vector<int> Values;
+
+Values values(int count)
+{
+    Values values;
+    for (int i(0); i < count; ++i) { values.push_back(i); }
+    return values;
+}
+
+int square(int value) { return value * value; }
+
+int scaled(int value, int factor) { return value * factor; }
+
+// MapOptions must not be taken for a sequence
+typedef decltype(utility::map("", std::declval<Values>(), &square))
+    PlainResult;
+typedef decltype(utility::map("", utility::MapOptions()
+                              , std::declval<Values>(), &square))
+    OptionsResult;
+static_assert(std::is_same<PlainResult, OptionsResult>::value
+              , "map overloads must return the same result type");
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(utility_map_dynamic)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/map dynamic schedule.");
+
+    typedef utility::MapOptions::Schedule Schedule;
+
+    const auto input(values(10000));
+    const auto partition(utility::map
+                         ("partition", utility::MapOptions
+                          (Schedule::partition, 4), input, &square));
+
+    for (std::size_t chunk : { 0, 1, 7, 20000 }) {
+        const auto dynamic(utility::map
+                           ("dynamic", utility::MapOptions
+                            (Schedule::dynamic, 4, chunk), input, &square));
+        BOOST_REQUIRE_EQUAL(dynamic.size(), partition.size());
+        for (std::size_t i(0); i < dynamic.size(); ++i) {
+            BOOST_REQUIRE_EQUAL(*dynamic[i], *partition[i]);
+        }
+    }
+
+    // extra arguments are passed through
+    const auto args(utility::map("args", utility::MapOptions
+                                 (Schedule::dynamic, 4), input, &scaled, 3));
+    BOOST_CHECK_EQUAL(*args[100], 300);
+}
+
+BOOST_AUTO_TEST_CASE(utility_map_dynamic_exception)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/map dynamic schedule exceptions.");
+
+    const auto result
+        (utility::map("throwing", utility::MapOptions
+                      (utility::MapOptions::Schedule::dynamic, 4, 3)
+                      , values(1000), [](int value) -> int
+    {
+        if (!(value % 10)) { throw std::range_error("bad value"); }
+        return value;
+    }));
+
+    for (int i(0); i < 1000; ++i) {
+        if (i % 10) {
+            BOOST_REQUIRE(result[i].valid());
+            BOOST_REQUIRE_EQUAL(*result[i], i);
+        } else {
+            BOOST_REQUIRE(!result[i].valid());
+            BOOST_REQUIRE_THROW(result[i].get(), std::range_error);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(utility_map_dynamic_nested)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/map nested dynamic schedule.");
+
+    typedef utility::MapOptions::Schedule Schedule;
+
+    // more threads than the pool has: callers must work too
+    const auto threads(4 * (utility::ThreadPool::shared().size() + 1));
+    const utility::MapOptions options(Schedule::dynamic, threads, 1);
+
+    const auto outer(utility::map("outer", options, values(32)
+                                  , [&](int value) -> int
+    {
+        int sum(0);
+        for (const auto &inner
+                 : utility::map("inner", options, values(100), &square))
+        {
+            sum += *inner;
+        }
+        return sum + value;
+    }));
+
+    for (int i(0); i < 32; ++i) {
+        BOOST_REQUIRE_EQUAL(*outer[i], 328350 + i);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(utility_map_threads_option)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/map threads option.");
+
+    std::mutex mutex;
+    std::set<std::thread::id> ids;
+    const auto record([&](int value) -> int
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::lock_guard<std::mutex> lock(mutex);
+        ids.insert(std::this_thread::get_id());
+        return value;
+    });
+
+    ::setenv("NO_THREADS", "1", 1);
+
+    // NO_THREADS: everything runs in the calling thread
+    utility::map("default", values(64), record);
+    BOOST_CHECK_EQUAL(ids.size(), 1);
+    BOOST_CHECK(ids.count(std::this_thread::get_id()));
+
+    // explicit thread count overrides NO_THREADS
+    ids.clear();
+    utility::map("explicit", utility::MapOptions
+                 (utility::MapOptions::Schedule::dynamic, 4, 1)
+                 , values(64), record);
+    BOOST_CHECK(ids.size() > 1);
+
+    ::unsetenv("NO_THREADS");
+}
+
+BOOST_AUTO_TEST_CASE(utility_stream_map_order)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/streamMap ordered delivery.");
+
+    // more threads than window slots
+    utility::MapOptions options(utility::MapOptions::Schedule::dynamic, 8);
+    options.window = 2;
+
+    const int count(500);
+    int pulled(0);
+    std::atomic<int> sunk(0);
+    std::atomic<int> maxInFlight(0);
+
+    utility::streamMap("order", options, [&]() -> boost::optional<int>
+    {
+        // generator is called under lock
+        if (pulled == count) { return boost::none; }
+        const int inFlight(++pulled - sunk);
+        if (inFlight > maxInFlight) { maxInFlight = inFlight; }
+        return pulled - 1;
+    }, [](int value) -> int
+    {
+        // make later items finish first
+        std::this_thread::sleep_for(std::chrono::microseconds
+                                    ((value % 3) * 100));
+        return value;
+    }, [&](utility::detail::Result<int> &result)
+    {
+        BOOST_REQUIRE_EQUAL(*result, int(sunk));
+        ++sunk;
+    });
+
+    BOOST_CHECK_EQUAL(sunk, count);
+    BOOST_CHECK(maxInFlight <= int(options.window));
+}
+
+BOOST_AUTO_TEST_CASE(utility_stream_map_range)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/streamMap range generator.");
+
+    const auto input(values(1000));
+    Values output;
+
+    utility::streamMap("range", utility::MapOptions
+                       (utility::MapOptions::Schedule::dynamic, 4)
+                       , utility::rangeGenerator(input.begin(), input.end())
+                       , &scaled
+                       , [&](utility::detail::Result<int> &result)
+    {
+        output.push_back(*result);
+    }, 2);
+
+    BOOST_REQUIRE_EQUAL(output.size(), input.size());
+    for (std::size_t i(0); i < input.size(); ++i) {
+        BOOST_REQUIRE_EQUAL(output[i], 2 * input[i]);
+    }
+
+    // empty range
+    output.clear();
+    utility::streamMap("empty", utility::MapOptions()
+                       , utility::rangeGenerator(input.end(), input.end())
+                       , &square
+                       , [&](utility::detail::Result<int> &result)
+    {
+        output.push_back(*result);
+    });
+    BOOST_CHECK(output.empty());
+}
+
+BOOST_AUTO_TEST_CASE(utility_stream_map_exception)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/streamMap exceptions.");
+
+    utility::MapOptions options(utility::MapOptions::Schedule::dynamic, 4);
+    options.window = 8;
+
+    std::atomic<int> running(0);
+    const auto slow([&](int value) -> int
+    {
+        ++running;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        --running;
+        return value;
+    });
+    const auto ignore([](utility::detail::Result<int>&) {});
+
+    // generator failure
+    int pulled(0);
+    int caught(0);
+    try {
+        utility::streamMap("generator", options, [&]()
+                           -> boost::optional<int>
+        {
+            if (pulled == 50) { throw std::range_error("generator"); }
+            return pulled++;
+        }, slow, ignore);
+    } catch (const std::range_error&) {
+        ++caught;
+    }
+    BOOST_CHECK_EQUAL(caught, 1);
+    BOOST_CHECK_EQUAL(running, 0);
+    BOOST_CHECK_EQUAL(pulled, 50);
+
+    // sink failure
+    const auto input(values(1000));
+    int sunk(0);
+    caught = 0;
+    try {
+        utility::streamMap("sink", options
+                           , utility::rangeGenerator(input.begin()
+                                                     , input.end())
+                           , slow, [&](utility::detail::Result<int> &result)
+        {
+            if (*result == 20) { throw std::range_error("sink"); }
+            ++sunk;
+        });
+    } catch (const std::range_error&) {
+        ++caught;
+    }
+    BOOST_CHECK_EQUAL(caught, 1);
+    BOOST_CHECK_EQUAL(running, 0);
+    BOOST_CHECK_EQUAL(sunk, 20);
+}
@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../memorypressure.hpp"
+
+#include "dbglog/dbglog.hpp"
+
+namespace {
+
+/** Cache stand-in, trim() is called from monitor thread.
+ */
+struct FakeCache {
+    std::atomic<std::size_t> cost;
+    FakeCache() : cost(1000) {}
+    std::size_t totalCost() const { return cost; }
+    std::size_t trim(std::size_t limit) {
+        if (cost > limit) { cost = limit; }
+        return 0;
+    }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(utility_memorypressure)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/MemoryPressureMonitor.");
+
+    const auto pressure(utility::MemoryPressure::read());
+    BOOST_CHECK(pressure.limit() > 0);
+    BOOST_CHECK(pressure.available() > 0);
+    BOOST_CHECK(pressure.available() <= pressure.limit());
+
+    // everything below 100% is moderate pressure
+    utility::MemoryPressureMonitor::Config config;
+    config.interval = std::chrono::milliseconds(10);
+    config.moderate = 1.0;
+    config.mallocTrim = false;
+    config.repeat = std::chrono::milliseconds(20);
+    utility::MemoryPressureMonitor monitor(config);
+
+    std::atomic<int> called(0);
+    std::atomic<bool> noPressure(false);
+    monitor.subscribe([&](const utility::MemoryPressure &p)
+    {
+        if (p.level == utility::MemoryPressure::Level::none) {
+            noPressure = true;
+        }
+        ++called;
+    });
+
+    FakeCache cache;
+    const auto subscription(monitor.trimOnPressure(cache, .5));
+
+    for (int i(0); (i < 500) && (called < 2); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    monitor.unsubscribe(subscription);
+
+    BOOST_CHECK(called >= 2);
+    BOOST_CHECK(!noPressure);
+    BOOST_CHECK(cache.totalCost() <= 250);
+}
+
+BOOST_AUTO_TEST_CASE(utility_memorypressure_repeat)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/MemoryPressureMonitor"
+                       " notification rate limit.");
+
+    // permanent moderate pressure, checked every 10 ms
+    utility::MemoryPressureMonitor::Config config;
+    config.interval = std::chrono::milliseconds(10);
+    config.moderate = 1.0;
+    config.mallocTrim = false;
+    config.repeat = std::chrono::hours(1);
+    utility::MemoryPressureMonitor monitor(config);
+
+    FakeCache cache;
+    const auto subscription(monitor.trimOnPressure(cache, .5));
+
+    for (int i(0); (i < 500) && (cache.totalCost() == 1000); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // many checks later the cache is still trimmed only once
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    monitor.unsubscribe(subscription);
+
+    BOOST_CHECK_EQUAL(cache.totalCost(), 500);
+}
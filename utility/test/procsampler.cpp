@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <sstream>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../procsampler.hpp"
+#include "../thread.hpp"
+
+#include "dbglog/dbglog.hpp"
+
+BOOST_AUTO_TEST_CASE(utility_procsampler)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/ProcSampler.");
+
+    // child process to have a tree
+    const auto child(::fork());
+    BOOST_REQUIRE(child >= 0);
+    if (!child) {
+        ::pause();
+        ::_exit(0);
+    }
+
+    utility::ProcSampler::Config config;
+    config.tree = true;
+    config.swap = true;
+    utility::ProcSampler sampler({}, config);
+
+    const auto &first(sampler.sample());
+    BOOST_REQUIRE(!first.empty());
+    BOOST_CHECK_EQUAL(first.front().stat.pid, ::getpid());
+    BOOST_CHECK(first.front().stat.rss > 0);
+    BOOST_CHECK(first.front().cpu < 0);
+
+    // burn some CPU
+    const auto end(std::chrono::steady_clock::now()
+                   + std::chrono::milliseconds(200));
+    volatile unsigned long spin(0);
+    while (std::chrono::steady_clock::now() < end) { ++spin; }
+
+    const auto &second(sampler.sample());
+    bool childFound(false);
+    for (const auto &sample : second) {
+        if (sample.stat.pid == child) {
+            childFound = true;
+            BOOST_CHECK_EQUAL(sample.stat.ppid, ::getpid());
+        }
+    }
+    BOOST_CHECK(childFound);
+    BOOST_CHECK(second.front().cpu > 10.0);
+    BOOST_CHECK(sampler.total().cpu >= second.front().cpu);
+
+    ::kill(child, SIGKILL);
+    ::waitpid(child, nullptr, 0);
+
+    BOOST_CHECK_EQUAL(sampler.sample().size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(utility_threadsampler)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/ThreadSampler.");
+
+    utility::ThreadSampler sampler;
+    BOOST_CHECK(!sampler.sample().empty());
+
+    std::atomic<bool> done(false);
+    std::thread busy([&]()
+    {
+        utility::thread::setName("busy");
+        const auto end(std::chrono::steady_clock::now()
+                       + std::chrono::milliseconds(200));
+        volatile unsigned long spin(0);
+        while (std::chrono::steady_clock::now() < end) { ++spin; }
+        while (!done) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    sampler.sample();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    bool found(false);
+    for (const auto &stat : sampler.sample()) {
+        if (stat.name != "busy") { continue; }
+        found = true;
+        BOOST_CHECK(stat.cpu > 10.0);
+        BOOST_CHECK(stat.utime + stat.stime > 0);
+    }
+    BOOST_CHECK(found);
+
+    std::ostringstream os;
+    sampler.report(os, "threads.", 1);
+    BOOST_CHECK_EQUAL(os.str().compare(0, 13, "threads.busy."), 0);
+
+    done = true;
+    busy.join();
+}
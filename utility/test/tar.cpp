@@ -0,0 +1,171 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "../tar.hpp"
+
+#include "dbglog/dbglog.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+/** Temporary directory removed at the end of the test.
+ */
+struct TempDir {
+    fs::path path;
+
+    TempDir()
+        : path(fs::temp_directory_path()
+               / fs::unique_path("tar-%%%%-%%%%"))
+    {
+        fs::create_directories(path);
+    }
+
+    ~TempDir() { fs::remove_all(path); }
+};
+
+/** Raw ustar header of given type and size.
+ */
+utility::tar::Header header(char type, std::size_t size
+                            , const std::string &name = "")
+{
+    utility::tar::Header header;
+    header.data.fill(0);
+    std::memcpy(header.name(), name.data(), std::min(name.size(), 99ul));
+    std::snprintf(header.mode(), 8, "%07o", 0644);
+    std::snprintf(header.size(), 12, "%011lo", static_cast<long>(size));
+    *header.typeflag() = type;
+    std::memcpy(header.magic(), "ustar", 6);
+    std::memcpy(header.version(), "00", 2);
+    return header;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(utility_tar_header_fields)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/tar header numeric fields.");
+
+    TempDir tmp;
+    const auto path(tmp.path / "fields.tar");
+    const std::string data("0123456789");
+    {
+        utility::tar::Writer tar(path);
+        tar.write("/file", data.data(), data.size(), 0777777);
+
+        // mtime does not fit into 11 octal digits
+        BOOST_CHECK_THROW(tar.write("/future", data.data(), data.size()
+                                    , std::time_t(1) << 40)
+                          , std::runtime_error);
+    }
+
+    utility::tar::Reader reader(path);
+    utility::tar::Header header;
+    BOOST_REQUIRE(reader.read(header));
+    BOOST_CHECK_EQUAL(std::string(header.size(), 12)
+                      , std::string("00000000012\0", 12));
+    BOOST_CHECK_EQUAL(header.getSize(), data.size());
+    BOOST_CHECK_EQUAL(header.getTime(), 0777777);
+}
+
+BOOST_AUTO_TEST_CASE(utility_tar_extended_headers)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/tar extended headers.");
+
+    TempDir tmp;
+    const auto path(tmp.path / "extended.tar");
+    const std::string longName("/some/rather/long/name");
+    const std::string pax("16 size=0000005\n");
+    {
+        // PAX size must not be applied to the GNU long name entry
+        utility::tar::Writer tar(path);
+        tar.write(header('x', pax.size()), pax.data(), pax.size());
+        tar.write(header('L', longName.size() + 1), longName.c_str()
+                  , longName.size() + 1);
+        tar.write(header('0', 5, "short"), "12345", 5);
+        tar.end();
+    }
+
+    utility::tar::IndexedReader reader(path);
+    BOOST_REQUIRE_EQUAL(reader.files().size(), 1);
+    BOOST_CHECK_EQUAL(reader.files()[0].path, longName);
+    BOOST_CHECK_EQUAL(reader.files()[0].size, 5);
+
+    const auto data(reader.readData(reader.find(longName)));
+    BOOST_CHECK_EQUAL(std::string(data.begin(), data.end()), "12345");
+
+    // legacy reader sees the same
+    utility::tar::Reader legacy(path);
+    const auto files(legacy.files());
+    BOOST_REQUIRE_EQUAL(files.size(), 1);
+    BOOST_CHECK_EQUAL(files[0].path, longName);
+    BOOST_CHECK_EQUAL(files[0].size, 5);
+    BOOST_CHECK_EQUAL(files[0].start, reader.files()[0].start);
+}
+
+BOOST_AUTO_TEST_CASE(utility_tar_long_names)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/tar Writer long names.");
+
+    TempDir tmp;
+    const auto path(tmp.path / "long.tar");
+
+    // fits name, needs prefix, needs PAX header
+    const std::vector<std::string> names{
+        "/short"
+        , "/" + std::string(120, 'p') + "/" + std::string(90, 'n')
+        , "/" + std::string(300, 'x')
+    };
+    {
+        utility::tar::Writer tar(path);
+        for (const auto &name : names) {
+            tar.write(name, name.data(), name.size());
+        }
+        tar.end();
+    }
+
+    utility::tar::IndexedReader indexed(path);
+    utility::tar::Reader legacy(path);
+    const auto files(legacy.files());
+
+    BOOST_REQUIRE_EQUAL(indexed.files().size(), names.size());
+    BOOST_REQUIRE_EQUAL(files.size(), names.size());
+    for (std::size_t i(0); i < names.size(); ++i) {
+        BOOST_CHECK_EQUAL(indexed.files()[i].path, names[i]);
+        BOOST_CHECK_EQUAL(files[i].path, names[i]);
+
+        const auto data(indexed.readData(indexed.find(names[i])));
+        BOOST_CHECK_EQUAL(std::string(data.begin(), data.end()), names[i]);
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../threadpool.hpp"
+
+#include "dbglog/dbglog.hpp"
+
+BOOST_AUTO_TEST_CASE(utility_threadpool)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/ThreadPool.");
+
+    std::atomic<int> done(0);
+    {
+        utility::ThreadPool pool(4, "test");
+        BOOST_CHECK_EQUAL(pool.size(), 4);
+
+        const utility::AsyncQueue &queue(pool);
+        for (int i(0); i < 100; ++i) {
+            queue.post([&]()
+            {
+                // nested posts go to worker's own deque
+                for (int j(0); j < 10; ++j) {
+                    queue.post([&]() { ++done; });
+                }
+                ++done;
+            });
+        }
+
+        // stop() runs everything queued
+        pool.stop();
+        BOOST_CHECK_EQUAL(pool.stats().executed, 1100);
+        BOOST_CHECK_EQUAL(pool.stats().depth, 0);
+        BOOST_CHECK_THROW(queue.post([]() {}), std::logic_error);
+    }
+    BOOST_CHECK_EQUAL(done, 1100);
+}
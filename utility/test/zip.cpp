@@ -0,0 +1,410 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "../zip.hpp"
+
+#include "dbglog/dbglog.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+/** Temporary directory removed at the end of the test.
+ */
+struct TempDir {
+    fs::path path;
+
+    TempDir()
+        : path(fs::temp_directory_path()
+               / fs::unique_path("zip-%%%%-%%%%"))
+    {
+        fs::create_directories(path);
+    }
+
+    ~TempDir() { fs::remove_all(path); }
+};
+
+std::string payload(std::size_t size)
+{
+    std::string data(size, '\0');
+    for (std::size_t i(0); i < size; ++i) { data[i] = char('a' + i % 26); }
+    return data;
+}
+
+void add(utility::zip::Writer &zip, const fs::path &path
+         , const std::string &data
+         , utility::zip::Compression compression
+         = utility::zip::Compression::store)
+{
+    auto os(zip.ostream(path, compression));
+    os->get() << data;
+    os->close();
+}
+
+/** Creates archive with single stored file.
+ */
+void single(const fs::path &path, const fs::path &file
+            , const std::string &data)
+{
+    utility::zip::Writer zip(path, true);
+    add(zip, file, data);
+    zip.close();
+}
+
+/** Replaces content of dst by content of src in place (inode is kept).
+ */
+void overwrite(const fs::path &dst, const fs::path &src)
+{
+    std::ifstream is(src.string(), std::ios::binary);
+    std::ofstream os(dst.string(), std::ios::binary | std::ios::trunc);
+    os << is.rdbuf();
+    os.close();
+    BOOST_REQUIRE(os);
+}
+
+void setModified(const fs::path &path, const ::timespec &modified)
+{
+    const ::timespec times[2] = { modified, modified };
+    BOOST_REQUIRE_EQUAL(::utimensat(AT_FDCWD, path.c_str(), times, 0), 0);
+}
+
+/** Reads whole file from archive (with CRC check).
+ */
+std::string content(const utility::zip::Reader &reader, const fs::path &path)
+{
+    boost::iostreams::filtering_istream fis;
+    reader.plug(reader.find(path), fis, true);
+    std::ostringstream os;
+    os << fis.rdbuf();
+    BOOST_CHECK(!os.fail());
+    return os.str();
+}
+
+/** Flips a byte inside the first occurrence of needle in the file.
+ */
+void corrupt(const fs::path &path, const std::string &needle)
+{
+    std::fstream f(path.string(), std::ios::in | std::ios::out
+                   | std::ios::binary);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    const auto pos(ss.str().find(needle));
+    BOOST_REQUIRE(pos != std::string::npos);
+    f.seekp(pos + needle.size() / 2);
+    f.put('#');
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(utility_zip_crc_mismatch)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/zip CRC32 check.");
+
+    TempDir tmp;
+    const auto path(tmp.path / "corrupt.zip");
+    const auto data(payload(1000));
+    {
+        utility::zip::Writer zip(path);
+        add(zip, "/file", data);
+        zip.close();
+    }
+
+    // intact file passes
+    {
+        utility::zip::Reader reader(path);
+        boost::iostreams::filtering_istream fis;
+        reader.plug(0, fis, true);
+        std::string out(data.size(), '\0');
+        fis.read(&out[0], out.size());
+        BOOST_CHECK(fis.good());
+        BOOST_CHECK_EQUAL(out, data);
+    }
+
+    corrupt(path, data);
+    utility::zip::Reader reader(path);
+
+    // reading exactly the file size
+    {
+        boost::iostreams::filtering_istream fis;
+        reader.plug(0, fis, true);
+        std::string out(data.size(), '\0');
+        BOOST_CHECK_THROW(fis.read(&out[0], out.size())
+                          , utility::zip::Error);
+        BOOST_CHECK(fis.bad());
+    }
+
+    // reading past the end
+    {
+        boost::iostreams::filtering_istream fis;
+        reader.plug(0, fis, true);
+        std::string out(2 * data.size(), '\0');
+        BOOST_CHECK_THROW(fis.read(&out[0], out.size())
+                          , utility::zip::Error);
+    }
+
+    // copying the buffer: error is reported on the destination stream
+    {
+        boost::iostreams::filtering_istream fis;
+        reader.plug(0, fis, true);
+        std::ostringstream os;
+        os << fis.rdbuf();
+        BOOST_CHECK(os.fail());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(utility_zip_map)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/zip memory mapping.");
+
+    TempDir tmp;
+    const auto path(tmp.path / "map.zip");
+    const auto data(payload(5000));
+    {
+        utility::zip::Writer zip(path);
+        add(zip, "/stored", data);
+        add(zip, "/deflated", data, utility::zip::Compression::deflate);
+        zip.close();
+    }
+
+    utility::zip::Reader reader(path);
+
+    // concurrent first use maps the archive once
+    std::atomic<int> errors(0);
+    std::vector<const char*> pointers(8);
+    std::vector<std::thread> threads;
+    for (std::size_t t(0); t < pointers.size(); ++t) {
+        threads.emplace_back([&, t]()
+        {
+            const auto mf(reader.map(*reader.tryFind("/stored")));
+            if (std::string(mf.data, mf.size) != data) { ++errors; }
+            pointers[t] = mf.data;
+        });
+    }
+    for (auto &thread : threads) { thread.join(); }
+
+    BOOST_CHECK_EQUAL(errors, 0);
+    for (const auto *pointer : pointers) {
+        BOOST_CHECK(pointer == pointers.front());
+    }
+
+    BOOST_CHECK_THROW(reader.map(*reader.tryFind("/deflated"))
+                      , utility::zip::Error);
+}
+
+BOOST_AUTO_TEST_CASE(utility_zip_parallel_writer)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/zip parallel writer.");
+
+    TempDir tmp;
+    const auto path(tmp.path / "parallel.zip");
+    const int threadCount(8), perThread(16);
+    const auto name([](int t, int i)
+    {
+        return "/t" + std::to_string(t) + "/f" + std::to_string(i);
+    });
+    const auto data([](int t, int i)
+    {
+        return payload(100 + 997 * t + 31 * i) + std::to_string(t * i);
+    });
+
+    {
+        utility::zip::Writer zip(path, utility::zip::Parallel);
+
+        // all ostreams of a thread are open at once, closed in reverse
+        std::vector<std::thread> threads;
+        for (int t(0); t < threadCount; ++t) {
+            threads.emplace_back([&, t]()
+            {
+                std::vector<utility::zip::Writer::OStream::pointer> oss;
+                for (int i(0); i < perThread; ++i) {
+                    oss.push_back(zip.ostream
+                                  (name(t, i)
+                                   , (i % 2)
+                                   ? utility::zip::Compression::deflate
+                                   : utility::zip::Compression::store));
+                    oss.back()->get() << data(t, i);
+                }
+                while (!oss.empty()) {
+                    oss.back()->close();
+                    oss.pop_back();
+                }
+            });
+        }
+        for (auto &thread : threads) { thread.join(); }
+        zip.close();
+    }
+
+    utility::zip::Reader reader(path);
+    BOOST_CHECK_EQUAL(reader.files().size(), threadCount * perThread);
+    for (int t(0); t < threadCount; ++t) {
+        for (int i(0); i < perThread; ++i) {
+            BOOST_CHECK(content(reader, name(t, i)) == data(t, i));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(utility_zip_stale_index)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/zip sidecar index validation.");
+
+    TempDir tmp;
+    const auto path(tmp.path / "archive.zip");
+    const auto other(tmp.path / "other.zip");
+    const auto index(tmp.path / "archive.zip.index");
+    const auto limit(std::numeric_limits<std::size_t>::max());
+
+    const auto open([&]()
+    {
+        return std::make_shared<utility::zip::Reader>
+            (path, limit, true, index);
+    });
+
+    single(path, "/a", "xxxx");
+    setModified(path, { 1000000, 100 });
+    BOOST_CHECK(open()->tryFind("/a"));
+    BOOST_CHECK(fs::exists(index));
+
+    // index is used while archive is untouched
+    BOOST_CHECK(open()->tryFind("/a"));
+
+    // same size and inode, mtime differs in nanoseconds only
+    single(other, "/b", "yyyy");
+    overwrite(path, other);
+    setModified(path, { 1000000, 200 });
+    {
+        auto reader(open());
+        BOOST_CHECK(!reader->tryFind("/a"));
+        BOOST_CHECK(reader->tryFind("/b"));
+    }
+
+    // same size, inode and mtime, central directory moved
+    single(other, "/ab", "zz");
+    BOOST_REQUIRE_EQUAL(fs::file_size(other), fs::file_size(path));
+    overwrite(path, other);
+    setModified(path, { 1000000, 200 });
+    {
+        auto reader(open());
+        BOOST_CHECK(!reader->tryFind("/b"));
+        BOOST_CHECK(reader->tryFind("/ab"));
+        BOOST_CHECK_EQUAL(content(*reader, "/ab"), "zz");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(utility_zip_random_read)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/zip random-offset read.");
+
+    TempDir tmp;
+    const auto path(tmp.path / "random.zip");
+    // not a multiple of checkpoint spacing nor of alphabet size
+    const auto data(payload(300007) + std::string(1000, 'x'));
+    {
+        utility::zip::Writer zip(path);
+        add(zip, "/stored", data);
+        add(zip, "/deflated", data, utility::zip::Compression::deflate);
+        zip.close();
+    }
+
+    utility::zip::Reader reader(path);
+    reader.checkpointSpacing(4096);
+
+    std::mt19937 rng(42);
+    for (const auto *name : { "/stored", "/deflated" }) {
+        const auto index(reader.find(name));
+
+        // chunks at random offsets, including ones crossing checkpoints
+        // and the end of file
+        for (int i(0); i < 200; ++i) {
+            const std::size_t offset(rng() % (data.size() + 10));
+            const std::size_t size(1 + rng() % 10000);
+
+            std::string out(size, '\0');
+            const auto read(reader.read(index, &out[0], size, offset));
+
+            const auto expect((offset < data.size())
+                              ? data.substr(offset, size)
+                              : std::string());
+            BOOST_REQUIRE_EQUAL(read, expect.size());
+            out.resize(read);
+            BOOST_CHECK(out == expect);
+        }
+
+        // concurrent readers share checkpoints
+        std::atomic<int> errors(0);
+        std::vector<std::thread> threads;
+        for (int t(0); t < 4; ++t) {
+            threads.emplace_back([&, t]()
+            {
+                std::mt19937 rng(t);
+                for (int i(0); i < 50; ++i) {
+                    const std::size_t offset(rng() % data.size());
+                    std::string out(1000, '\0');
+                    out.resize(reader.read(index, &out[0], out.size()
+                                           , offset));
+                    if (out != data.substr(offset, 1000)) { ++errors; }
+                }
+            });
+        }
+        for (auto &thread : threads) { thread.join(); }
+        BOOST_CHECK_EQUAL(errors, 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(utility_zip_find)
+{
+    BOOST_TEST_MESSAGE("* Testing utility/zip path lookup.");
+
+    TempDir tmp;
+    const auto path(tmp.path / "find.zip");
+    single(path, "/dir/file", "data");
+
+    for (bool sanitize : { true, false }) {
+        utility::zip::Reader reader
+            (path, std::numeric_limits<std::size_t>::max(), sanitize);
+        for (const auto *name : { "/dir/file", "/dir//file", "/dir/./file"
+                    , "/dir/file/", "/./dir/file/." })
+        {
+            BOOST_CHECK_MESSAGE(reader.tryFind(name)
+                                , name << " not found (sanitize="
+                                << sanitize << ")");
+        }
+        BOOST_CHECK(!reader.tryFind("/dir"));
+        BOOST_CHECK(!reader.tryFind("/dir/file/x"));
+    }
+}
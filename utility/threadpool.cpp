@@ -0,0 +1,212 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <stdexcept>
+
+#include "dbglog/dbglog.hpp"
+
+#include "threadpool.hpp"
+#include "thread.hpp"
+#include "logging.hpp"
+
+namespace utility {
+
+namespace {
+
+/** Pool and worker index of current thread.
+ */
+thread_local const ThreadPool *currentPool(nullptr);
+thread_local std::size_t currentWorker(0);
+
+} // namespace
+
+struct ThreadPool::Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    std::thread thread;
+};
+
+ThreadPool::ThreadPool(std::size_t threads, const std::string &name)
+    : name_(name), pending_(0), next_(0), sleepers_(0), running_(true)
+    , executed_(0), stolen_(0), totalLatency_(0), maxLatency_(0)
+{
+    if (!threads) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (std::size_t i(0); i < threads; ++i) {
+        workers_.emplace_back(new Worker());
+    }
+
+    for (std::size_t i(0); i < threads; ++i) {
+        workers_[i]->thread = std::thread(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    try {
+        stop();
+    } catch (...) {}
+}
+
+void ThreadPool::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(idleMutex_);
+        if (!running_) { return; }
+        running_ = false;
+    }
+    idleCond_.notify_all();
+
+    for (auto &worker : workers_) {
+        if (worker->thread.joinable()) { worker->thread.join(); }
+    }
+}
+
+void ThreadPool::post_impl(const Operation &op) const
+{
+    // operations running during stop() may still post continuations
+    if (!running_ && (currentPool != this)) {
+        LOGTHROW(err2, std::logic_error)
+            << "Thread pool <" << name_ << "> is stopped.";
+    }
+
+    // own deque when posted from a worker, round-robin otherwise
+    const auto index((currentPool == this)
+                     ? currentWorker : (next_++ % workers_.size()));
+    {
+        auto &worker(*workers_[index]);
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(Task{op, Clock::now()});
+    }
+    ++pending_;
+
+    if (sleepers_) {
+        std::unique_lock<std::mutex> lock(idleMutex_);
+        idleCond_.notify_one();
+    }
+}
+
+bool ThreadPool::take(std::size_t index, Task &task)
+{
+    {
+        // own deque, newest first
+        auto &worker(*workers_[index]);
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        if (!worker.tasks.empty()) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // steal oldest from others
+    const auto size(workers_.size());
+    for (std::size_t i(1); i < size; ++i) {
+        auto &victim(*workers_[(index + i) % size]);
+        std::unique_lock<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            ++stolen_;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::execute(Task &task)
+{
+    const std::uint64_t latency
+        (std::chrono::duration_cast<std::chrono::microseconds>
+         (Clock::now() - task.posted).count());
+    totalLatency_ += latency;
+    auto max(maxLatency_.load());
+    while ((latency > max)
+           && !maxLatency_.compare_exchange_weak(max, latency)) {}
+
+    try {
+        task.op();
+    } catch (const std::exception &e) {
+        LOG(err2) << "Operation failed: <" << e.what() << ">.";
+    } catch (...) {
+        LOG(err2) << "Operation failed with unknown exception.";
+    }
+    ++executed_;
+}
+
+void ThreadPool::run(std::size_t index)
+{
+    const auto id(name_ + std::to_string(index));
+    thread::setName(id);
+    LogThreadId logThreadId(id);
+
+    currentPool = this;
+    currentWorker = index;
+
+    for (;;) {
+        Task task;
+        if (take(index, task)) {
+            --pending_;
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idleMutex_);
+        ++sleepers_;
+        idleCond_.wait(lock, [&]() { return pending_ || !running_; });
+        --sleepers_;
+
+        // finish only when there is nothing left to do
+        if (!running_ && !pending_) { break; }
+    }
+
+    currentPool = nullptr;
+}
+
+ThreadPool::Stats ThreadPool::stats() const
+{
+    Stats stats;
+    stats.depth = pending_;
+    stats.executed = executed_;
+    stats.stolen = stolen_;
+    stats.totalLatency = totalLatency_;
+    stats.maxLatency = maxLatency_;
+    return stats;
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool(0, "shared");
+    return pool;
+}
+
+} // namespace utility
@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2026 Melown Technologies SE
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * *  Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/**
+ * @file utility/threadpool.hpp
+ *
+ * Work-stealing thread pool implementing AsyncQueue.
+ */
+
+#ifndef utility_threadpool_hpp_included_
+#define utility_threadpool_hpp_included_
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "asyncqueue.hpp"
+
+namespace utility {
+
+/** Fixed-size thread pool with per-worker task deques.
+ *
+ *  Operations posted from a worker thread go to the worker's own deque
+ *  (and are run LIFO by the owner), operations posted from other threads
+ *  are distributed round-robin. Idle workers steal oldest operations from
+ *  other workers' deques.
+ *
+ *  Worker threads are named "<name><index>" (both OS thread name and
+ *  dbglog thread id).
+ *
+ *  Exceptions thrown by operations are logged and swallowed.
+ */
+class ThreadPool : public AsyncQueue, boost::noncopyable {
+public:
+    /** Starts pool with given number of threads (zero means number of
+     *  hardware threads).
+     */
+    ThreadPool(std::size_t threads = 0, const std::string &name = "pool");
+
+    /** Stops the pool, see stop().
+     */
+    virtual ~ThreadPool();
+
+    /** Runs all queued operations and joins all threads. Posting to a stopped
+     *  pool (from other than worker thread) throws std::logic_error. Must not
+     *  be called from a worker thread.
+     */
+    void stop();
+
+    std::size_t size() const { return workers_.size(); }
+
+    struct Stats {
+        /** Number of queued (not yet started) operations.
+         */
+        std::size_t depth;
+
+        std::uint64_t executed;
+
+        /** Number of operations run by other worker than they were queued
+         *  to.
+         */
+        std::uint64_t stolen;
+
+        /** Total and maximum time between post and start of operation, in
+         *  microseconds.
+         */
+        std::uint64_t totalLatency;
+        std::uint64_t maxLatency;
+
+        Stats()
+            : depth(), executed(), stolen(), totalLatency(), maxLatency()
+        {}
+    };
+
+    Stats stats() const;
+
+    /** Process-wide pool with default number of threads. Created on first
+     *  use.
+     */
+    static ThreadPool& shared();
+
+private:
+    virtual void post_impl(const Operation &op) const;
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Task {
+        Operation op;
+        Clock::time_point posted;
+    };
+
+    struct Worker;
+
+    void run(std::size_t index);
+
+    /** Takes task from own deque or steals one from others.
+     */
+    bool take(std::size_t index, Task &task);
+
+    void execute(Task &task);
+
+    const std::string name_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    mutable std::atomic<std::size_t> pending_;
+    mutable std::atomic<std::size_t> next_;
+    mutable std::atomic<std::size_t> sleepers_;
+
+    mutable std::mutex idleMutex_;
+    mutable std::condition_variable idleCond_;
+    std::atomic<bool> running_;
+
+    std::atomic<std::uint64_t> executed_;
+    std::atomic<std::uint64_t> stolen_;
+    std::atomic<std::uint64_t> totalLatency_;
+    std::atomic<std::uint64_t> maxLatency_;
+};
+
+} // namespace utility
+
+#endif // utility_threadpool_hpp_included_
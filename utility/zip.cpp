@@ -26,9 +26,14 @@
 
 #include <sys/stat.h>
 #include <sys/types.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 #include <fcntl.h>
 
+#include <array>
 #include <ctime>
+#include <mutex>
 #include <system_error>
 
 #include <boost/utility/in_place_factory.hpp>
@@ -37,7 +42,11 @@
 #include <boost/iostreams/filter/bzip2.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
 #include <boost/iostreams/device/array.hpp>
-#include <boost/crc.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+
+#ifdef UTILITY_HAS_ZLIB
+#  include <zlib.h>
+#endif
 
 #include "utility/unistd_compat.hpp"
 #include "dbglog/dbglog.hpp"
@@ -49,6 +58,7 @@
 #include "filedes.hpp"
 #include "scopedguard.hpp"
 #include "typeinfo.hpp"
+#include "filesystem.hpp"
 
 /*
 Format documentation (Library of Congress preserved version):
@@ -118,6 +128,7 @@ namespace bio = boost::iostreams;
 namespace utility { namespace zip {
 
 EmbedFlag Embed;
+ParallelFlag Parallel;
 
 namespace detail {
 
@@ -318,6 +329,7 @@ struct CentralDirectoryFileHeader {
         MinimalFileHeader mh;
         mh.flag = flag;
         mh.compressionMethod = compressionMethod;
+        mh.crc32 = crc32;
         mh.compressedSize = compressedSize;
         mh.uncompressedSize = uncompressedSize;
         mh.filenameSize = filename.size();
@@ -700,6 +712,76 @@ int findCentralDirectory(Stream &f, std::size_t fileLength)
     return off;
 }
 
+/** CRC-32 (ISO-HDLC, as used by ZIP) computed by slicing-by-8 algorithm,
+ *  i.e. 8 bytes are processed in one step.
+ */
+class Crc32 {
+public:
+    Crc32() : crc_(0xffffffffu) {}
+
+    void process(const void *data, std::size_t size);
+
+    std::uint32_t checksum() const { return crc_ ^ 0xffffffffu; }
+
+private:
+    typedef std::array<std::array<std::uint32_t, 256>, 8> Tables;
+
+    static const Tables& tables();
+
+    std::uint32_t crc_;
+};
+
+const Crc32::Tables& Crc32::tables()
+{
+    static const Tables tables([]() -> Tables
+    {
+        Tables t;
+        for (std::uint32_t i(0); i < 256; ++i) {
+            auto c(i);
+            for (int k(0); k < 8; ++k) {
+                c = (c & 1) ? (0xedb88320u ^ (c >> 1)) : (c >> 1);
+            }
+            t[0][i] = c;
+        }
+
+        for (std::uint32_t i(0); i < 256; ++i) {
+            for (std::size_t k(1); k < t.size(); ++k) {
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+            }
+        }
+        return t;
+    }());
+
+    return tables;
+}
+
+void Crc32::process(const void *data, std::size_t size)
+{
+    const auto &t(tables());
+    const auto *p(static_cast<const unsigned char*>(data));
+    auto crc(crc_);
+
+    // NB: assumes little endian host, as does the rest of this file
+    for (; size >= 8; size -= 8, p += 8) {
+        std::uint32_t one, two;
+        std::memcpy(&one, p, sizeof(one));
+        std::memcpy(&two, p + 4, sizeof(two));
+        one ^= crc;
+
+        crc = (t[7][one & 0xff] ^ t[6][(one >> 8) & 0xff]
+               ^ t[5][(one >> 16) & 0xff] ^ t[4][one >> 24]
+               ^ t[3][two & 0xff] ^ t[2][(two >> 8) & 0xff]
+               ^ t[1][(two >> 16) & 0xff] ^ t[0][two >> 24]);
+    }
+
+    // tail
+    for (; size; --size, ++p) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+    }
+
+    crc_ = crc;
+}
+
 class CentralDirectoryReader {
 public:
     CentralDirectoryReader(const Filedes &fd)
@@ -728,6 +810,7 @@ public:
                 "in zip file " << path_ << ".";
         }
 
+        eocdOffset_ = fileLength_ - off;
         f_.seekg(-off, std::ios_base::end);
         eocd_ = EndOfCentralDirectoryRecord::read(f_);
 
@@ -743,6 +826,15 @@ public:
         return true;
     }
 
+    /** Valid after successful open().
+     */
+    const EndOfCentralDirectoryRecord& eocd() const { return eocd_; }
+
+    /** Position of (non-64) end of central directory record. Valid after
+     *  successful open().
+     */
+    std::size_t eocdOffset() const { return eocdOffset_; }
+
     template <typename Callback>
     void read(const Callback &callback
               , std::size_t limit = std::numeric_limits<std::size_t>::max())
@@ -778,8 +870,84 @@ private:
     const std::size_t fileLength_;
     boost::iostreams::stream<utility::io::SubStreamDevice> f_;
     EndOfCentralDirectoryRecord eocd_;
+    std::size_t eocdOffset_ = 0;
+};
+
+/** Memory mapping of whole archive, created on first use. Without mmap
+ *  (Windows) the whole archive is read into memory instead.
+ */
+struct Mapping {
+    Mapping(const Filedes &fd, std::size_t length)
+        : fd(fd.get()), path(fd.path()), length(length), data()
+    {}
+
+    ~Mapping() {
+#ifndef _WIN32
+        if (data) { ::munmap(const_cast<char*>(data), length); }
+#endif
+    }
+
+    /** Returns mapped data. Only the first call maps the archive (failed
+     *  attempt is retried by the next call).
+     */
+    const char* get() {
+        std::call_once(once, [this]() { map(); });
+        return data;
+    }
+
+    const int fd;
+    const fs::path path;
+    const std::size_t length;
+    const char *data;
+    std::once_flag once;
+
+private:
+    void map() {
+#ifndef _WIN32
+        auto mem(::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0));
+        if (mem == MAP_FAILED) {
+            std::system_error e(errno, std::system_category());
+            LOG(err2) << "Cannot mmap zip file " << path << ": <"
+                      << e.code() << ", " << e.what() << ">.";
+            throw e;
+        }
+        data = static_cast<const char*>(mem);
+#else
+        buffer.reset(new char[length]);
+        std::size_t total(0);
+        while (total < length) {
+            auto res(::pread(fd, buffer.get() + total, length - total
+                             , total));
+            if (res == -1) {
+                if (errno == EINTR) { continue; }
+                std::system_error e(errno, std::system_category());
+                LOG(err2) << "Cannot read zip file " << path << ": <"
+                          << e.code() << ", " << e.what() << ">.";
+                throw e;
+            }
+            if (!res) {
+                LOGTHROW(err2, Error)
+                    << "Unexpected end of zip file " << path << ".";
+            }
+            total += res;
+        }
+        data = buffer.get();
+#endif
+    }
+
+#ifdef _WIN32
+    std::unique_ptr<char[]> buffer;
+#endif
 };
 
+template <typename T>
+T peek(const char *data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
 } // namespace detail
 
 // pull in everything from detail namespace above
@@ -803,15 +971,284 @@ bool Reader::check(const boost::filesystem::path &path)
     return false;
 }
 
-Reader::Reader(const fs::path &path, std::size_t limit, bool sanitizePaths)
+namespace {
+
+/** Sidecar index file layout (all values in host byte order):
+ *
+ *     IndexHeader
+ *     IndexRecord[recordCount]
+ *     char strings[stringsSize] (paths, not terminated)
+ */
+const char IndexMagic[8] = { 'U', 'Z', 'I', 'P', 'I', 'D', 'X', '\0' };
+constexpr std::uint32_t IndexVersion = 3;
+constexpr std::uint32_t IndexFlagSanitized = 1u;
+
+struct IndexHeader {
+    char magic[sizeof(IndexMagic)];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint64_t archiveSize;
+    std::int64_t archiveModified;
+    std::int64_t archiveModifiedNsec;
+    std::uint64_t archiveDev;
+    std::uint64_t archiveIno;
+    std::uint64_t eocdOffset;
+    std::uint64_t centralDirectoryOffset;
+    std::uint64_t limit;
+    std::uint64_t recordCount;
+    std::uint64_t stringsSize;
+};
+
+struct IndexRecord {
+    std::uint64_t headerStart;
+    std::uint64_t compressedSize;
+    std::uint64_t uncompressedSize;
+    std::uint64_t pathOffset;
+    std::uint32_t pathSize;
+    std::uint16_t flag;
+    std::uint16_t compressionMethod;
+    std::uint16_t filenameSize;
+    std::uint16_t fileExtraSize;
+    std::uint32_t crc32;
+};
+
+static_assert(sizeof(IndexHeader) == 96, "Unexpected IndexHeader layout.");
+static_assert(sizeof(IndexRecord) == 48, "Unexpected IndexRecord layout.");
+
+/** Nanosecond part of file modification time (0 where not available).
+ */
+std::int64_t modifiedNsec(const Filedes &fd)
+{
+#ifdef _WIN32
+    (void) fd;
+    return 0;
+#else
+    struct ::stat s;
+    if (-1 == ::fstat(fd, &s)) {
+        std::system_error e(errno, std::system_category());
+        LOG(err1) << "Cannot stat file " << fd.path() << ": <"
+                  << e.code() << ", " << e.what() << ">.";
+        throw e;
+    }
+#  ifdef __APPLE__
+    return s.st_mtimespec.tv_nsec;
+#  else
+    return s.st_mtim.tv_nsec;
+#  endif
+#endif
+}
+
+/** Index header describing current state of the archive, including
+ *  position of its central directory (i.e. the archive's tail is read
+ *  anyway; touched archive is detected even if it keeps size and mtime).
+ */
+IndexHeader indexHeader(const Filedes &fd
+                        , const CentralDirectoryReader &cdr
+                        , std::size_t limit, bool sanitizePaths)
+{
+    const auto stat(FileStat::from(fd));
+
+    IndexHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, IndexMagic, sizeof(IndexMagic));
+    h.version = IndexVersion;
+    h.flags = (sanitizePaths ? IndexFlagSanitized : 0);
+    h.archiveSize = stat.size;
+    h.archiveModified = stat.modified;
+    h.archiveModifiedNsec = modifiedNsec(fd);
+    h.archiveDev = stat.id.dev;
+    h.archiveIno = stat.id.id;
+    h.eocdOffset = cdr.eocdOffset();
+    h.centralDirectoryOffset = cdr.eocd().centralDirectoryOffset;
+    h.limit = limit;
+    return h;
+}
+
+/** Loads records from sidecar index. Returns false if index is missing,
+ *  invalid or stale.
+ */
+bool loadIndex(const fs::path &indexPath, const IndexHeader &expect
+               , Reader::Record::list &records)
+{
+    Filedes fd(::open(indexPath.string().c_str(), O_RDONLY), indexPath);
+    if (!fd) { return false; }
+
+    const auto stat(FileStat::from(fd, std::nothrow));
+    if (stat.size < sizeof(IndexHeader)) { return false; }
+
+    // read whole index at once
+    std::vector<char> data(stat.size);
+    {
+        std::size_t total(0);
+        while (total < data.size()) {
+            auto res(::pread(fd, data.data() + total, data.size() - total
+                             , total));
+            if (res == -1) {
+                if (errno == EINTR) { continue; }
+                return false;
+            }
+            if (!res) { return false; }
+            total += res;
+        }
+    }
+
+    IndexHeader h;
+    std::memcpy(&h, data.data(), sizeof(h));
+
+    // compare everything but record count and strings size
+    if (std::memcmp(&h, &expect, offsetof(IndexHeader, recordCount))) {
+        return false;
+    }
+
+    // check counts before any arithmetic: crafted values must not overflow
+    if (h.recordCount > ((data.size() - sizeof(IndexHeader))
+                         / sizeof(IndexRecord)))
+    {
+        return false;
+    }
+
+    const auto stringsStart(sizeof(IndexHeader)
+                            + h.recordCount * sizeof(IndexRecord));
+    if (h.stringsSize != (data.size() - stringsStart)) { return false; }
+
+    const auto *strings(data.data() + stringsStart);
+
+    records.clear();
+    records.reserve(h.recordCount);
+    const auto *raw(data.data() + sizeof(IndexHeader));
+    for (std::size_t i(0); i != h.recordCount; ++i) {
+        IndexRecord ir;
+        std::memcpy(&ir, raw + i * sizeof(IndexRecord), sizeof(ir));
+        if ((ir.pathOffset > h.stringsSize)
+            || (ir.pathSize > (h.stringsSize - ir.pathOffset)))
+        {
+            records.clear();
+            return false;
+        }
+
+        MinimalFileHeader mh;
+        mh.flag = ir.flag;
+        mh.compressionMethod = ir.compressionMethod;
+        mh.crc32 = ir.crc32;
+        mh.compressedSize = ir.compressedSize;
+        mh.uncompressedSize = ir.uncompressedSize;
+        mh.filenameSize = ir.filenameSize;
+        mh.fileExtraSize = ir.fileExtraSize;
+
+        records.emplace_back
+            (i, std::string(strings + ir.pathOffset, ir.pathSize)
+             , ir.headerStart, mh);
+    }
+
+    return true;
+}
+
+/** Writes sidecar index. Written into temporary file and then atomically
+ *  renamed.
+ */
+void saveIndex(const fs::path &indexPath, IndexHeader h
+               , const Reader::Record::list &records)
+{
+    std::vector<char> data(sizeof(IndexHeader)
+                           + records.size() * sizeof(IndexRecord));
+    std::string strings;
+
+    auto *raw(data.data() + sizeof(IndexHeader));
+    for (const auto &record : records) {
+        const auto path(record.path.string());
+
+        IndexRecord ir;
+        std::memset(&ir, 0, sizeof(ir));
+        ir.headerStart = record.headerStart;
+        ir.compressedSize = record.header.compressedSize;
+        ir.uncompressedSize = record.header.uncompressedSize;
+        ir.pathOffset = strings.size();
+        ir.pathSize = path.size();
+        ir.flag = record.header.flag;
+        ir.compressionMethod = record.header.compressionMethod;
+        ir.filenameSize = record.header.filenameSize;
+        ir.fileExtraSize = record.header.fileExtraSize;
+        ir.crc32 = record.header.crc32;
+
+        std::memcpy(raw, &ir, sizeof(ir));
+        raw += sizeof(ir);
+        strings.append(path);
+    }
+
+    h.recordCount = records.size();
+    h.stringsSize = strings.size();
+    std::memcpy(data.data(), &h, sizeof(h));
+    data.insert(data.end(), strings.begin(), strings.end());
+
+    const fs::path tmpPath(indexPath.string() + ".tmp");
+    Filedes fd(::open(tmpPath.string().c_str()
+                      , O_WRONLY | O_CREAT | O_TRUNC
+                      , (S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH))
+               , tmpPath);
+    if (!fd) {
+        std::system_error e(errno, std::system_category());
+        LOG(warn2) << "Cannot create zip index file " << tmpPath << ": <"
+                   << e.code() << ", " << e.what() << ">.";
+        return;
+    }
+
+    std::size_t total(0);
+    while (total < data.size()) {
+        auto res(::write(fd, data.data() + total, data.size() - total));
+        if (res == -1) {
+            if (errno == EINTR) { continue; }
+            std::system_error e(errno, std::system_category());
+            LOG(warn2) << "Cannot write zip index file " << tmpPath << ": <"
+                       << e.code() << ", " << e.what() << ">.";
+            ::unlink(tmpPath.string().c_str());
+            return;
+        }
+        total += res;
+    }
+    fd.close();
+
+    if (-1 == ::rename(tmpPath.string().c_str()
+                       , indexPath.string().c_str()))
+    {
+        std::system_error e(errno, std::system_category());
+        LOG(warn2) << "Cannot rename zip index file " << tmpPath
+                   << " to " << indexPath << ": <"
+                   << e.code() << ", " << e.what() << ">.";
+        ::unlink(tmpPath.string().c_str());
+    }
+}
+
+} // namespace
+
+Reader::Reader(const fs::path &path, std::size_t limit, bool sanitizePaths
+               , const fs::path &indexPath)
     : path_(path), fd_(openFile(path))
     , fileLength_(fileSize(fd_))
+    , mapping_(std::make_shared<Mapping>(fd_, fileLength_))
+    , checkpointSpacing_(DefaultCheckpointSpacing)
+    , checkpoints_(std::make_shared<Checkpoints>())
 {
+    boost::optional<IndexHeader> ih;
+
     try {
-        // open and read central directory
+
+        // open central directory
         CentralDirectoryReader cdr(fd_, fileLength_);
         cdr.open();
 
+        if (!indexPath.empty()) {
+            ih = indexHeader(fd_, cdr, limit, sanitizePaths);
+
+            if (loadIndex(indexPath, *ih, records_)) {
+                LOG(debug) << "Loaded " << records_.size()
+                           << " records of ZIP archive " << path_
+                           << " from index " << indexPath << ".";
+                buildIndex();
+                return;
+            }
+        }
+
+        // read central directory
         cdr.read([&](int i, const CentralDirectoryFileHeader &cdfh) -> void
         {
             records_.emplace_back(i, sanitize(cdfh.filename, sanitizePaths)
@@ -822,25 +1259,127 @@ Reader::Reader(const fs::path &path, std::size_t limit, bool sanitizePaths)
             << "Cannot process the zip file " << path << ": " << e.what()
             << ".";
     }
+
+    if (ih) { saveIndex(indexPath, *ih, records_); }
+
+    buildIndex();
 }
 
-std::size_t Reader::find(const boost::filesystem::path &path) const
+namespace {
+
+/** Path index key: path elements joined by single slashes, dot elements
+ *  dropped, i.e. "a//b", "a/./b" and "a/b/" all make "a/b". Double-dots
+ *  are kept (resolved by sanitization only).
+ */
+std::string indexKey(const fs::path &path)
 {
-    auto frecords(std::find_if(records_.begin(), records_.end()
-                               , [&](const Record &r) {
-                                   return r.path == path;
-                               }));
-    if (frecords == records_.end()) {
-        LOGTHROW(err2, Error)
-            << "File " << path << "not found in zip file "
-            << path_ << ".";
+    std::string key;
+    for (const auto &element : path) {
+        const auto &e(element.string());
+        if (e == ".") { continue; }
+        if (!key.empty() && (key.back() != '/')) { key.push_back('/'); }
+        key.append(e);
     }
+    return key;
+}
 
-    return (&*frecords - records_.data());
+} // namespace
+
+void Reader::buildIndex()
+{
+    index_.reserve(records_.size());
+    for (const auto &record : records_) {
+        index_.emplace(indexKey(record.path), record.index);
+    }
 }
 
+boost::optional<std::size_t>
+Reader::tryFind(const boost::filesystem::path &path) const
+{
+    auto findex(index_.find(indexKey(path)));
+    if (findex == index_.end()) { return boost::none; }
+    return findex->second;
+}
+
+std::size_t Reader::find(const boost::filesystem::path &path) const
+{
+    if (const auto index = tryFind(path)) { return *index; }
+
+    LOGTHROW(err2, Error)
+        << "File " << path << " not found in zip file "
+        << path_ << ".";
+    throw;
+}
+
+namespace {
+
+/** Default filter buffer (128 bytes) is too small for CRC computation.
+ */
+constexpr std::streamsize CrcBufferSize = 1 << 16;
+
+/** Input filter computing CRC32 and size of passing data. Checks both
+ *  against expected values as soon as expected size is reached (or exceeded)
+ *  or at EOF, whichever comes first.
+ */
+class Crc32CheckFilter : public bio::multichar_input_filter
+{
+public:
+    Crc32CheckFilter(const fs::path &path, std::uint32_t crc32
+                     , std::size_t size)
+        : path_(path), expectedCrc32_(crc32), expectedSize_(size), size_()
+        , checked_()
+    {}
+
+    template<typename Source>
+    std::streamsize read(Source &src, char_type *s, std::streamsize n) {
+        const auto result(bio::read(src, s, n));
+        if (result > 0) {
+            crc32_.process(s, result);
+            size_ += result;
+            if (!checked_ && (size_ >= expectedSize_)) {
+                // all data seen, do not wait for EOF that may never be read
+                checked_ = true;
+                check();
+            }
+        } else if (n && !checked_) {
+            // EOF; NB: underlying SubStreamDevice signals EOF by zero
+            checked_ = true;
+            check();
+        }
+        return result;
+    }
+
+private:
+    void check() const {
+        if (size_ != expectedSize_) {
+            LOGTHROW(err2, Error)
+                << "Size mismatch in file " << path_ << ": expected "
+                << expectedSize_ << " bytes, got " << size_ << " bytes.";
+        }
+
+        const auto crc32(crc32_.checksum());
+        if (crc32 != expectedCrc32_) {
+            LOGTHROW(err2, Error)
+                << "CRC32 mismatch in file " << path_ << ": expected 0x"
+                << std::setfill('0') << std::hex << std::setw(8)
+                << expectedCrc32_ << " got 0x"
+                << std::hex << std::setw(8) << crc32 << ".";
+        }
+    }
+
+    fs::path path_;
+    std::uint32_t expectedCrc32_;
+    std::size_t expectedSize_;
+    std::size_t size_;
+    Crc32 crc32_;
+    bool checked_;
+};
+
+} // namespace
+
 PluggedFile Reader::plug(std::size_t index
-                         , boost::iostreams::filtering_istream &fis)
+                         , boost::iostreams::filtering_istream &fis
+                         , bool verifyCrc)
     const
 {
     if (index >= records_.size())  {
@@ -872,13 +1411,23 @@ PluggedFile Reader::plug(std::size_t index
     bool seekable(false);
     std::size_t safetyPadding(0);
 
+    if (verifyCrc) {
+        // check uncompressed data; seeking would break the computation
+        fis.push(Crc32CheckFilter(record.path, record.header.crc32
+                                  , record.header.uncompressedSize)
+                 , CrcBufferSize);
+
+        // std::istream turns exceptions from the filter into badbit
+        fis.exceptions(fis.exceptions() | std::ios::badbit);
+    }
+
     // add decompressor based on compression method
     switch (const auto cm
             = static_cast<CompressionMethod>(header.compressionMethod))
     {
     case CompressionMethod::store:
         // not compressed, no decompressor needed
-        seekable = true;
+        seekable = !verifyCrc;
         break;
 
     case CompressionMethod::bzip2:
@@ -910,12 +1459,433 @@ PluggedFile Reader::plug(std::size_t index
     return PluggedFile(record.path, header.uncompressedSize, seekable);
 }
 
+MappedFile Reader::map(std::size_t index) const
+{
+    if (index >= records_.size())  {
+        LOGTHROW(err2, Error)
+            << "Invalid file index " << index << " in zip file "
+            << path_ << ".";
+    }
+
+    // grab record
+    const auto &record(records_[index]);
+
+    const auto cm(static_cast<CompressionMethod>
+                  (record.header.compressionMethod));
+    if (cm != CompressionMethod::store) {
+        LOGTHROW(err2, Error)
+            << "Cannot map file " << record.path << " compressed by <"
+            << cm << "> from the zip file " << path_
+            << "; only stored files can be mapped.";
+    }
+
+    if ((record.headerStart + localFileHeaderSize) > fileLength_) {
+        LOGTHROW(err2, Error)
+            << "Local header of file " << record.path
+            << " lies outside of the zip file " << path_ << ".";
+    }
+
+    const auto *data(mapping_->get());
+
+    // parse local header in place; we need just signature and variable sizes
+    const auto *header(data + record.headerStart);
+    if (peek<std::uint32_t>(header) != LOCAL_HEADER_SIGNATURE) {
+        LOGTHROW(err2, BadSignature)
+            << "Error reading local file header of file " << record.path
+            << " in the zip file " << path_ << ": invalid signature.";
+    }
+
+    // filename and extra field sizes are the last two fields of the header
+    const auto filenameSize(peek<std::uint16_t>
+                            (header + localFileHeaderSize
+                             - 2 * sizeof(std::uint16_t)));
+    const auto fileExtraSize(peek<std::uint16_t>
+                             (header + localFileHeaderSize
+                              - sizeof(std::uint16_t)));
+
+    const std::size_t fileStart(record.headerStart + localFileHeaderSize
+                                + filenameSize + fileExtraSize);
+    const std::size_t fileEnd(fileStart + record.header.compressedSize);
+    if (fileEnd > fileLength_) {
+        LOGTHROW(err2, Error)
+            << "File " << record.path << " lies outside of the zip file "
+            << path_ << ".";
+    }
+
+    return MappedFile(record.path, data + fileStart
+                      , record.header.compressedSize);
+}
+
+namespace {
+
+/** Reads exactly size bytes at given offset (less only at EOF).
+ */
+std::size_t preadAll(const Filedes &fd, void *data, std::size_t size
+                     , std::size_t offset)
+{
+    auto *p(static_cast<char*>(data));
+    std::size_t total(0);
+    while (total < size) {
+        auto res(::pread(fd, p + total, size - total, offset + total));
+        if (res == -1) {
+            if (errno == EINTR) { continue; }
+            std::system_error e(errno, std::system_category());
+            LOG(err2) << "Cannot read from zip file " << fd.path() << ": <"
+                      << e.code() << ", " << e.what() << ">.";
+            throw e;
+        }
+        if (!res) { break; }
+        total += res;
+    }
+    return total;
+}
+
+} // namespace
+
+namespace detail {
+
+#ifdef UTILITY_HAS_ZLIB
+
+/** Deflate decompressor state at some point of the file. Based on zran.c
+ *  from zlib examples.
+ */
+struct Checkpoint {
+    /** Offset in uncompressed data.
+     */
+    std::uint64_t out;
+
+    /** Offset of first full byte in compressed data.
+     */
+    std::uint64_t in;
+
+    /** Number of bits (1-7) from byte at in - 1, or 0.
+     */
+    int bits;
+
+    /** Up to 32 KB of uncompressed data preceding this point.
+     */
+    std::vector<unsigned char> window;
+
+    Checkpoint(std::uint64_t out, std::uint64_t in, int bits)
+        : out(out), in(in), bits(bits)
+    {}
+
+    typedef std::vector<Checkpoint> list;
+};
+
+constexpr std::size_t InflateWindowSize = 1 << 15;
+constexpr std::size_t InflateChunkSize = 1 << 16;
+
+/** Raw inflate stream reading compressed data directly from the archive.
+ */
+struct Inflater {
+    Inflater(const Filedes &fd, const fs::path &path, std::size_t start
+             , std::size_t compressedSize, std::size_t inPos = 0)
+        : fd(fd), path(path), start(start), compressedSize(compressedSize)
+        , inPos(inPos), input(InflateChunkSize)
+    {
+        std::memset(&strm, 0, sizeof(strm));
+        check(::inflateInit2(&strm, -15), "initialize inflate");
+    }
+
+    ~Inflater() { ::inflateEnd(&strm); }
+
+    void check(int res, const char *what) const {
+        if (res == Z_OK) { return; }
+        LOGTHROW(err2, Error)
+            << "Cannot " << what << " for file " << path << ": "
+            << (strm.msg ? strm.msg : "unknown error") << " (" << res << ").";
+    }
+
+    /** Inflates data, reads more input if needed. Returns true at stream
+     *  end.
+     */
+    bool inflate(int flush) {
+        if (!strm.avail_in && (inPos < compressedSize)) {
+            const auto size(std::min<std::uint64_t>
+                            (input.size(), compressedSize - inPos));
+            const auto read(preadAll(fd, input.data(), size, start + inPos));
+            inPos += read;
+            strm.avail_in = read;
+            strm.next_in = input.data();
+        }
+
+        switch (auto res = ::inflate(&strm, flush)) {
+        case Z_OK: return false;
+        case Z_STREAM_END: return true;
+
+        case Z_BUF_ERROR:
+            // no progress possible
+            if (strm.avail_out && !strm.avail_in) {
+                LOGTHROW(err2, Error)
+                    << "Premature end of compressed data of file "
+                    << path << ".";
+            }
+            return false;
+
+        case Z_NEED_DICT: check(Z_DATA_ERROR, "inflate data"); break;
+        default: check(res, "inflate data"); break;
+        }
+        return false;
+    }
+
+    const Filedes &fd;
+    const fs::path &path;
+    const std::size_t start;
+    const std::size_t compressedSize;
+    std::size_t inPos;
+    std::vector<unsigned char> input;
+    z_stream strm;
+};
+
+/** Decompresses whole file and remembers decompressor state every spacing
+ *  bytes of uncompressed data.
+ */
+Checkpoint::list buildCheckpoints(const Filedes &fd, const fs::path &path
+                                  , std::size_t start
+                                  , std::size_t compressedSize
+                                  , std::size_t spacing)
+{
+    // start of the stream is always a checkpoint
+    Checkpoint::list checkpoints;
+    checkpoints.emplace_back(0, 0, 0);
+
+    Inflater inflater(fd, path, start, compressedSize);
+    auto &strm(inflater.strm);
+
+    std::vector<unsigned char> window(InflateWindowSize);
+
+    // input/output totals at checkpoint, i.e. without buffered data
+    std::uint64_t totin(0);
+    std::uint64_t totout(0);
+    std::uint64_t last(0);
+
+    for (bool end(false); !end; ) {
+        if (!strm.avail_out) {
+            strm.avail_out = window.size();
+            strm.next_out = window.data();
+        }
+
+        const auto availIn(strm.avail_in);
+        const auto availOut(strm.avail_out);
+        const auto inPos(inflater.inPos);
+        end = inflater.inflate(Z_BLOCK);
+        totin += (inflater.inPos - inPos) + availIn - strm.avail_in;
+        totout += availOut - strm.avail_out;
+        if (end) { break; }
+
+        // at block boundary (but not after last block)?
+        if ((strm.data_type & 128) && !(strm.data_type & 64)
+            && ((totout - last) >= spacing))
+        {
+            checkpoints.emplace_back(totout, totin, strm.data_type & 7);
+            auto &cp(checkpoints.back());
+
+            // unroll circular window, keep only valid data
+            const std::size_t left(strm.avail_out);
+            const auto have(std::min<std::uint64_t>(totout, window.size()));
+            std::vector<unsigned char> dict;
+            dict.reserve(window.size());
+            dict.insert(dict.end(), window.end() - left, window.end());
+            dict.insert(dict.end(), window.begin(), window.end() - left);
+            cp.window.assign(dict.end() - have, dict.end());
+
+            last = totout;
+        }
+    }
+
+    return checkpoints;
+}
+
+/** Inflates size bytes from given offset using nearest checkpoint.
+ */
+std::size_t readDeflated(const Filedes &fd, const fs::path &path
+                         , std::size_t start, std::size_t compressedSize
+                         , const Checkpoint::list &checkpoints
+                         , char *data, std::size_t size
+                         , std::size_t offset)
+{
+    // find last checkpoint at or before offset
+    auto icp(std::upper_bound(checkpoints.begin(), checkpoints.end(), offset
+                              , [](std::size_t offset, const Checkpoint &cp)
+                              {
+                                  return offset < cp.out;
+                              }));
+    if (icp == checkpoints.begin()) {
+        LOGTHROW(err2, Error)
+            << "No checkpoint for offset " << offset << " in file "
+            << path << ".";
+    }
+    const auto &cp(*--icp);
+
+    Inflater inflater(fd, path, start, compressedSize, cp.in);
+    auto &strm(inflater.strm);
+
+    if (cp.bits) {
+        unsigned char byte;
+        if (!preadAll(fd, &byte, 1, start + cp.in - 1)) {
+            LOGTHROW(err2, Error)
+                << "Premature end of compressed data of file " << path << ".";
+        }
+        inflater.check(::inflatePrime(&strm, cp.bits, byte >> (8 - cp.bits))
+                       , "prime inflate");
+    }
+
+    if (!cp.window.empty()) {
+        inflater.check(::inflateSetDictionary
+                       (&strm, cp.window.data(), cp.window.size())
+                       , "set inflate dictionary");
+    }
+
+    std::vector<unsigned char> discard(InflateWindowSize);
+
+    // bytes to skip before requested range
+    auto skip(offset - cp.out);
+    std::size_t total(0);
+
+    for (bool end(false); !end && (total < size); ) {
+        if (skip) {
+            const auto out(std::min<std::uint64_t>(skip, discard.size()));
+            strm.next_out = discard.data();
+            strm.avail_out = out;
+            end = inflater.inflate(Z_NO_FLUSH);
+            skip -= (out - strm.avail_out);
+        } else {
+            strm.next_out = reinterpret_cast<unsigned char*>(data + total);
+            strm.avail_out = size - total;
+            end = inflater.inflate(Z_NO_FLUSH);
+            total = size - strm.avail_out;
+        }
+    }
+
+    return total;
+}
+
+/** Lazily built checkpoints for deflated files.
+ */
+struct Checkpoints {
+    typedef std::shared_ptr<const Checkpoint::list> pointer;
+
+    pointer get(std::size_t index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto fmap(map.find(index));
+        if (fmap == map.end()) { return {}; }
+        return fmap->second;
+    }
+
+    pointer add(std::size_t index, Checkpoint::list &&checkpoints) {
+        std::lock_guard<std::mutex> lock(mutex);
+        // keep first one if computed in parallel
+        return map.emplace
+            (index, std::make_shared<const Checkpoint::list>
+             (std::move(checkpoints))).first->second;
+    }
+
+    std::mutex mutex;
+    std::unordered_map<std::size_t, pointer> map;
+};
+
+#else // UTILITY_HAS_ZLIB
+
+/** No zlib, no checkpoints.
+ */
+struct Checkpoints {};
+
+#endif // UTILITY_HAS_ZLIB
+
+} // namespace detail
+
+std::size_t Reader::fileStart(const Record &record) const
+{
+    char header[localFileHeaderSize];
+    if (preadAll(fd_, header, sizeof(header), record.headerStart)
+        != sizeof(header))
+    {
+        LOGTHROW(err2, Error)
+            << "Local header of file " << record.path
+            << " lies outside of the zip file " << path_ << ".";
+    }
+
+    if (peek<std::uint32_t>(header) != LOCAL_HEADER_SIGNATURE) {
+        LOGTHROW(err2, BadSignature)
+            << "Error reading local file header of file " << record.path
+            << " in the zip file " << path_ << ": invalid signature.";
+    }
+
+    // filename and extra field sizes are the last two fields of the header
+    const auto filenameSize(peek<std::uint16_t>
+                            (header + localFileHeaderSize
+                             - 2 * sizeof(std::uint16_t)));
+    const auto fileExtraSize(peek<std::uint16_t>
+                             (header + localFileHeaderSize
+                              - sizeof(std::uint16_t)));
+
+    return (record.headerStart + localFileHeaderSize
+            + filenameSize + fileExtraSize);
+}
+
+std::size_t Reader::read(std::size_t index, char *data, std::size_t size
+                         , std::size_t offset) const
+{
+    if (index >= records_.size())  {
+        LOGTHROW(err2, Error)
+            << "Invalid file index " << index << " in zip file "
+            << path_ << ".";
+    }
+
+    // grab record
+    const auto &record(records_[index]);
+
+    // trim range to file size
+    if (offset >= record.header.uncompressedSize) { return 0; }
+    size = std::min<std::size_t>
+        (size, record.header.uncompressedSize - offset);
+    if (!size) { return 0; }
+
+    switch (static_cast<CompressionMethod>(record.header.compressionMethod))
+    {
+    case CompressionMethod::store:
+        return preadAll(fd_, data, size, fileStart(record) + offset);
+
+#ifdef UTILITY_HAS_ZLIB
+    case CompressionMethod::deflate: {
+        const auto start(fileStart(record));
+
+        auto checkpoints(checkpoints_->get(index));
+        if (!checkpoints) {
+            LOG(debug) << "Building checkpoints for file " << record.path
+                       << " in the zip file " << path_ << ".";
+            checkpoints = checkpoints_->add
+                (index, buildCheckpoints(fd_, record.path, start
+                                         , record.header.compressedSize
+                                         , checkpointSpacing_));
+        }
+
+        return readDeflated(fd_, record.path, start
+                            , record.header.compressedSize
+                            , *checkpoints, data, size, offset);
+    }
+#endif // UTILITY_HAS_ZLIB
+
+    default: break;
+    }
+
+    // fallback: decompress from the start and skip unwanted data
+    bio::filtering_istream fis;
+    plug(index, fis);
+    fis.ignore(offset);
+    fis.read(data, size);
+    return fis.gcount();
+}
+
 struct Writer::Detail : public std::enable_shared_from_this<Detail>
 {
     typedef std::shared_ptr<Detail> pointer;
 
     Detail(const boost::filesystem::path &path, bool overwrite);
     Detail(const boost::filesystem::path &path, const EmbedFlag&);
+    Detail(const boost::filesystem::path &path, const ParallelFlag&
+           , bool overwrite);
 
     ~Detail() {
         if (fd) {
@@ -948,8 +1918,23 @@ struct Writer::Detail : public std::enable_shared_from_this<Detail>
     // TODO: pass record info
     void commit(const FileEntry &fileEntry);
 
+    /** Appends file (header + buffered data) at the end of the archive.
+     *  Used in parallel mode.
+     */
+    void commit(const FileEntry &fileEntry, const std::vector<char> &data);
+
     void rollback();
 
+    /** Builds central directory file header for given file.
+     */
+    CentralDirectoryFileHeader header(const FileEntry &fileEntry
+                                      , std::size_t offset) const;
+
+    /** Adds header to the directory; replaces existing entry with the same
+     *  filename.
+     */
+    void addToDirectory(const CentralDirectoryFileHeader &fh);
+
     void seekTo(std::size_t off) {
         auto res(::lseek(fd, off, SEEK_SET));
         if (res == -1) {
@@ -1003,7 +1988,19 @@ struct Writer::Detail : public std::enable_shared_from_this<Detail>
 
     ::off_t tx;
 
+    /** Parallel mode: ostreams are buffered.
+     */
+    bool parallel;
+
+    /** Serializes access to the file and directory.
+     */
+    std::mutex mutex;
+
     CentralDirectoryFileHeader::list directory;
+
+    /** Filename -> directory index mapping.
+     */
+    std::unordered_map<std::string, std::size_t> directoryIndex;
 };
 
 namespace {
@@ -1051,12 +2048,18 @@ Filedes openFile(const boost::filesystem::path &path, OpenMode openMode)
 } // namespace
 
 Writer::Detail::Detail(const boost::filesystem::path &path, bool overwrite)
-    : fd(openFile(path, openMode(overwrite))), tx(-1)
+    : fd(openFile(path, openMode(overwrite))), tx(-1), parallel(false)
+{
+}
+
+Writer::Detail::Detail(const boost::filesystem::path &path
+                       , const ParallelFlag&, bool overwrite)
+    : fd(openFile(path, openMode(overwrite))), tx(-1), parallel(true)
 {
 }
 
 Writer::Detail::Detail(const boost::filesystem::path &path, const EmbedFlag&)
-    : fd(openFile(path, OpenMode::append)), tx(-1)
+    : fd(openFile(path, OpenMode::append)), tx(-1), parallel(false)
 {
     CentralDirectoryReader cdr(fd);
     if (!cdr.open(true)) {
@@ -1068,7 +2071,7 @@ Writer::Detail::Detail(const boost::filesystem::path &path, const EmbedFlag&)
     try {
         cdr.read([&](int, const CentralDirectoryFileHeader &cdfh) -> void
         {
-            directory.push_back(cdfh);
+            addToDirectory(cdfh);
         });
     } catch (const std::ios_base::failure &e) {
         LOGTHROW(err2, Error)
@@ -1119,14 +2122,14 @@ public:
     template<typename Sink>
     std::streamsize write(Sink &sink, const char_type *s, std::streamsize n) {
         auto result(bio::write(sink, s, n));
-        crc32_.process_bytes(s, result);
+        crc32_.process(s, result);
         return result;
     }
 
     std::uint32_t checksum() const { return crc32_.checksum(); }
 
 private:
-    boost::crc_32_type crc32_;
+    Crc32 crc32_;
 };
 
 class ZipStream : public Writer::OStream
@@ -1136,8 +2139,9 @@ public:
               , Compression compression, const Writer::FilterInit &filterInit)
         : detail_(std::move(detail))
         , fileEntry_(name, compressionMethod(compression))
+        , buffered_(detail_->parallel)
     {
-        detail_->begin(fileEntry_.name.string());
+        if (!buffered_) { detail_->begin(fileEntry_.name.string()); }
         open_ = true;
 
         if (filterInit) { filterInit(fos_); }
@@ -1169,10 +2173,16 @@ public:
 
         // measure compressed size
         fos_.push(boost::ref(compressedSize_));
-        // sink to file
-        fos_.push(bio::file_descriptor_sink
-                   (detail_->fd.get()
-                    , bio::file_descriptor_flags::never_close_handle));
+
+        if (buffered_) {
+            // sink to memory, written to file in close()
+            fos_.push(bio::back_inserter(buffer_));
+        } else {
+            // sink to file
+            fos_.push(bio::file_descriptor_sink
+                      (detail_->fd.get()
+                       , bio::file_descriptor_flags::never_close_handle));
+        }
     }
 
     virtual ~ZipStream() {
@@ -1201,7 +2211,12 @@ public:
                ? uncompressedSize_->count() : fileEntry_.compressedSize);
         fileEntry_.crc32 = crc32_.checksum();
 
-        detail_->commit(fileEntry_);
+        if (buffered_) {
+            detail_->commit(fileEntry_, buffer_);
+            std::vector<char>().swap(buffer_);
+        } else {
+            detail_->commit(fileEntry_);
+        }
 
         return Statistics(fileEntry_.compressedSize
                           , fileEntry_.uncompressedSize);
@@ -1211,6 +2226,9 @@ private:
     Writer::Detail::pointer detail_;
     Writer::Detail::FileEntry fileEntry_;
 
+    bool buffered_;
+    std::vector<char> buffer_;
+
     bool open_;
     bio::filtering_ostream fos_;
 
@@ -1401,19 +2419,7 @@ void Writer::Detail::commit(const FileEntry &fe)
             << "Not inside a transaction.";
     }
 
-    CentralDirectoryFileHeader fh;
-
-    fh.versionNeeded = VERSION_NEEDED;
-    fh.versionMadeBy = VERSION_MADE_BY;
-    fh.compressionMethod = static_cast<decltype(fh.compressionMethod)>
-        (fe.compressionMethod);
-    std::tie(fh.modificationDate, fh.modificationTime) = msDateTime();
-    fh.crc32 = fe.crc32;
-    fh.compressedSize = fe.compressedSize;
-    fh.uncompressedSize = fe.uncompressedSize;
-    fh.externalFileAttributes = REGULAR_FILE_ATTRIBUTES;
-    fh.filename = fe.name.string();
-    fh.fileOffset = tx;
+    const auto fh(header(fe, tx));
 
     try {
         // write a file header
@@ -1433,22 +2439,73 @@ void Writer::Detail::commit(const FileEntry &fe)
         throw;
     }
 
+    addToDirectory(fh);
+
+    tx = -1;
+}
+
+CentralDirectoryFileHeader
+Writer::Detail::header(const FileEntry &fe, std::size_t offset) const
+{
+    CentralDirectoryFileHeader fh;
+
+    fh.versionNeeded = VERSION_NEEDED;
+    fh.versionMadeBy = VERSION_MADE_BY;
+    fh.compressionMethod = static_cast<decltype(fh.compressionMethod)>
+        (fe.compressionMethod);
+    std::tie(fh.modificationDate, fh.modificationTime) = msDateTime();
+    fh.crc32 = fe.crc32;
+    fh.compressedSize = fe.compressedSize;
+    fh.uncompressedSize = fe.uncompressedSize;
+    fh.externalFileAttributes = REGULAR_FILE_ATTRIBUTES;
+    fh.filename = fe.name.string();
+    fh.fileOffset = offset;
+
+    return fh;
+}
+
+void Writer::Detail::addToDirectory(const CentralDirectoryFileHeader &fh)
+{
     // try to find a record with the same path
-    auto fdirectory(std::find_if(directory.begin(), directory.end()
-                                 , [&](const CentralDirectoryFileHeader &h)
-                                 {
-                                     return (h.filename == fh.filename);
-                                 }));
+    auto res(directoryIndex.emplace(fh.filename, directory.size()));
 
-    if (fdirectory == directory.end()) {
+    if (res.second) {
         // not found, append
         directory.push_back(fh);
     } else {
         // found, replace
-        *fdirectory = fh;
+        directory[res.first->second] = fh;
     }
+}
 
-    tx = -1;
+void Writer::Detail::commit(const FileEntry &fe, const std::vector<char> &data)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!fd) {
+        LOGTHROW(err2, Error)
+            << "ZIP archive " << fd.path() << " is closed.";
+    }
+
+    const auto start(seekEnd());
+    const auto fh(header(fe, start));
+
+    try {
+        bio::stream<bio::file_descriptor_sink> os
+            (fd.get(), bio::file_descriptor_flags::never_close_handle);
+        os.exceptions(std::ios::badbit | std::ios::failbit);
+        writeLocalHeader(os, fh);
+        bin::write(os, data.data(), data.size());
+        bio::close(os);
+    } catch (const std::exception &e) {
+        LOG(err2) << "Cannot commit a ZIP file " << fd.path()
+                  << "; rolling back.";
+        tx = start;
+        rollback();
+        throw;
+    }
+
+    addToDirectory(fh);
 }
 
 void Writer::Detail::rollback()
@@ -1472,6 +2529,8 @@ void Writer::Detail::rollback()
 
 void Writer::Detail::close()
 {
+    std::lock_guard<std::mutex> lock(mutex);
+
     if (!fd) { return; }
 
     // this ensures fd is closed even if tail write fails
@@ -1533,6 +2592,12 @@ Writer::Writer(const boost::filesystem::path &path, const EmbedFlag &embed)
 {
 }
 
+Writer::Writer(const boost::filesystem::path &path
+               , const ParallelFlag &parallel, bool overwrite)
+    : detail_(std::make_shared<Detail>(path, parallel, overwrite))
+{
+}
+
 Writer::~Writer() {}
 
 void Writer::close()
@@ -39,7 +39,9 @@
 #include <vector>
 #include <limits>
 #include <memory>
+#include <unordered_map>
 
+#include <boost/optional.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 
@@ -68,19 +70,34 @@ struct PluggedFile {
     {}
 };
 
+/** Read-only view of file data inside memory-mapped archive. Valid as long as
+ *  originating reader exists.
+ */
+struct MappedFile {
+    boost::filesystem::path path;
+    const char *data;
+    std::size_t size;
+
+    MappedFile(boost::filesystem::path path, const char *data
+               , std::size_t size)
+        : path(path), data(data), size(size)
+    {}
+};
+
 namespace detail {
 
 struct MinimalFileHeader {
     std::uint16_t flag;
     std::uint16_t compressionMethod;
+    std::uint32_t crc32;
     std::uint64_t compressedSize;
     std::uint64_t uncompressedSize;
     std::uint16_t filenameSize;
     std::uint16_t fileExtraSize;
 
     MinimalFileHeader()
-        : flag(), compressionMethod(), compressedSize(), uncompressedSize()
-        , filenameSize(), fileExtraSize()
+        : flag(), compressionMethod(), crc32(), compressedSize()
+        , uncompressedSize(), filenameSize(), fileExtraSize()
     {}
 
     void read(std::istream &in);
@@ -88,6 +105,9 @@ struct MinimalFileHeader {
     std::size_t size() const;
 };
 
+struct Mapping;
+struct Checkpoints;
+
 } // namespace detail
 
 class Reader {
@@ -104,13 +124,23 @@ public:
      *  Rationale behind 4: ZIP archive works as a full filesystem with
      *  predictable paths.
      *
+     * If index path is given the file list is loaded from this sidecar index
+     * file instead of parsing the central directory. Index is validated
+     * against archive's size, modification time (including nanoseconds),
+     * device, inode and position of its central directory (only the tail of
+     * the archive is read) and regenerated when stale or missing. Failure to
+     * write index is not fatal.
+     *
      * \param path path to archive
      * \param limit limit number of files read into file list
      * \param sanitizePaths sanities paths
+     * \param indexPath path to sidecar index file (optional)
      */
     Reader(const boost::filesystem::path &path
            , std::size_t limit = std::numeric_limits<std::size_t>::max()
-           , bool sanitizePaths = true);
+           , bool sanitizePaths = true
+           , const boost::filesystem::path &indexPath
+           = boost::filesystem::path());
 
     /** File record.
      */
@@ -134,17 +164,69 @@ public:
 
     const Record::list& files() const { return records_; }
 
+    /** Finds file with given path. Throws Error when not found.
+     */
     std::size_t find(const boost::filesystem::path &path) const;
 
+    /** Finds file with given path. Returns none when not found.
+     */
+    boost::optional<std::size_t>
+    tryFind(const boost::filesystem::path &path) const;
+
     /** Plug decompressing stream for file at given index at the end of the
      *  filtering_istream.
+     *
+     * If asked to, CRC32 of uncompressed data is computed and checked (as
+     * well as uncompressed size) against the value stored in the central
+     * directory as soon as all data are read (or at premature end of file).
+     * Error is thrown on mismatch: badbit is added to fis.exceptions() so
+     * that reads through fis throw. NB: stream inserters reading the buffer
+     * directly (os << fis.rdbuf()) swallow the error and set failbit on the
+     * destination stream instead; check it.
      */
     PluggedFile plug(std::size_t index
-                     , boost::iostreams::filtering_istream &fis) const;
+                     , boost::iostreams::filtering_istream &fis
+                     , bool verifyCrc = false) const;
+
+    /** Maps file at given index directly from memory-mapped archive. Only
+     *  stored (i.e. not compressed) files are supported. Whole archive is
+     *  mapped on first call and kept mapped until reader is destroyed.
+     */
+    MappedFile map(std::size_t index) const;
+
+    /** Reads part of uncompressed file at given index. Returns number of read
+     *  bytes which is less than size only at the end of file.
+     *
+     *  Stored files are read directly. For deflated files, checkpoints
+     *  (decompressor state every checkpointSpacing() bytes of uncompressed
+     *  data) are built on first access to given file and decompression
+     *  starts at the nearest checkpoint before offset. Other files are
+     *  decompressed from the start.
+     *
+     *  Safe to call from multiple threads.
+     */
+    std::size_t read(std::size_t index, char *data, std::size_t size
+                     , std::size_t offset) const;
+
+    static constexpr std::size_t DefaultCheckpointSpacing = 1 << 20;
+
+    /** Distance between deflate checkpoints. Applies only to checkpoints
+     *  built afterwards.
+     */
+    void checkpointSpacing(std::size_t spacing) {
+        checkpointSpacing_ = spacing;
+    }
+    std::size_t checkpointSpacing() const { return checkpointSpacing_; }
 
     static bool check(const boost::filesystem::path &path);
 
 private:
+    void buildIndex();
+
+    /** Returns start of file data (i.e. after local header).
+     */
+    std::size_t fileStart(const Record &record) const;
+
     boost::filesystem::path path_;
 
     /** Open file descriptor.
@@ -158,6 +240,25 @@ private:
     /** List of records.
      */
     Record::list records_;
+
+    /** Path to index into records_ mapping. First record wins when there are
+     *  duplicate paths in the archive. Keyed by normalized path (redundant
+     *  slashes and dot elements removed) both on insert and lookup.
+     */
+    typedef std::unordered_map<std::string, std::size_t> PathIndex;
+    PathIndex index_;
+
+    /** Lazily created memory mapping of whole archive.
+     */
+    std::shared_ptr<detail::Mapping> mapping_;
+
+    /** Distance between deflate checkpoints.
+     */
+    std::size_t checkpointSpacing_;
+
+    /** Lazily built deflate checkpoints.
+     */
+    std::shared_ptr<detail::Checkpoints> checkpoints_;
 };
 
 UTILITY_GENERATE_ENUM(Compression,
@@ -169,6 +270,9 @@ UTILITY_GENERATE_ENUM(Compression,
 struct EmbedFlag {};
 extern EmbedFlag Embed;
 
+struct ParallelFlag {};
+extern ParallelFlag Parallel;
+
 /** Simple ZIP archive writer
  */
 class Writer {
@@ -185,6 +289,20 @@ public:
      */
     Writer(const boost::filesystem::path &path, const EmbedFlag&);
 
+    /** Creates new (empty) archive in parallel mode.
+     *
+     * Any number of ostreams can be open at once and used from different
+     * threads. Each ostream compresses its data into its own memory buffer
+     * (i.e. compression runs in parallel in the writing threads) and the
+     * buffer is appended to the archive (under lock) when the ostream is
+     * closed. Files are stored in the archive in the order of closing.
+     *
+     * \param path path to archive
+     * \param overwrite do not fail if file already exists when true
+     */
+    Writer(const boost::filesystem::path &path, const ParallelFlag&
+           , bool overwrite = false);
+
     /** Destroys zip file. Warns on non-closed archive.
      */
     ~Writer();